@@ -0,0 +1,90 @@
+#ifndef FWLJMET_LJMet_interface_AK8FeatureCache_h
+#define FWLJMET_LJMet_interface_AK8FeatureCache_h
+
+/*
+ Per-event cache of AK8 substructure quantities shared by the calculators
+ (JetSubCalc, BestCalc). Owned by the event selector, reset
+ after the AK8 jet selection, and filled lazily one jet at a time.
+ */
+
+#include <iostream>
+#include <vector>
+#include <utility> // std::pair
+
+#include "FWCore/Framework/interface/Event.h"
+#include "DataFormats/PatCandidates/interface/Jet.h"
+
+#include "TLorentzVector.h"
+
+class JetMETCorrHelper;
+class BTagSFUtil;
+
+class AK8FeatureCache {
+public:
+
+    /// Soft-drop (Puppi) subjet, kinematics corrected with the selector's JEC
+    struct SubjetFeatures {
+        edm::Ptr<pat::Jet> subjet; // discriminators are untouched by the correction, read them here
+        double pt;
+        double eta;
+        double phi;
+        double mass;
+        double csvv2;
+        int    hadronFlavour;
+        bool   btag[5]; // BTagSFUtil shiftflag: nominal, bSFup, bSFdn, lSFup, lSFdn
+    };
+
+    struct JetFeatures {
+        bool filled;
+        unsigned int nDaughters;
+        double softDropMassPuppi; // userFloat("ak8PFJetsPuppiSoftDropMass")
+        double tau1;
+        double tau2;
+        double tau3;
+        TLorentzVector softDropRawP4; // sum of uncorrected soft-drop subjets
+        std::vector<SubjetFeatures> subjets;
+        std::vector<std::pair<int,double> > chargedConstituents; // (charge, pt) from getJetConstituents()
+        double chargeSumKappa;
+        double chargeSum;
+    };
+
+    AK8FeatureCache();
+    ~AK8FeatureCache() { }
+
+    /// Hook up the selector's jet correction and b-tagging tools, called once in the selector BeginJob
+    void Initialize(JetMETCorrHelper * jetMETCorr,
+                    BTagSFUtil * btagSfUtil,
+                    edm::EDGetTokenT<double> rhoJetsToken,
+                    bool reCorrectJet,
+                    unsigned int syst,
+                    bool isMc);
+
+    /// Invalidate all entries; called by the selector once vSelCorrJets_AK8 is final for this event
+    void Reset(edm::Event const & event, std::vector<pat::Jet> const & jets);
+
+    unsigned int size() const { return mvFeatures.size(); }
+
+    /// Features of the i-th selected AK8 jet, computed on first access in the event
+    JetFeatures const & Get(unsigned int i) { if(!mvFeatures[i].filled) fill(i); return mvFeatures[i]; }
+
+    /// sum_i q_i * pt_i^kappa over the jet constituents (JetSubCalc jet charge numerator)
+    double ConstituentChargeSum(unsigned int i, double kappa);
+
+private:
+    void fill(unsigned int i);
+
+    std::string mLegend;
+
+    JetMETCorrHelper * mpJetMETCorr;
+    BTagSFUtil * mpBtagSfUtil;
+    edm::EDGetTokenT<double> mRhoJetsToken;
+    bool mReCorrectJet;
+    unsigned int mSyst;
+    bool mIsMc;
+
+    edm::Event const * mpEvent;
+    std::vector<pat::Jet> const * mpJets;
+    std::vector<JetFeatures> mvFeatures;
+};
+
+#endif
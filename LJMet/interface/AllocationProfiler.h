@@ -0,0 +1,90 @@
+#ifndef FWLJMET_LJMet_interface_AllocationProfiler_h
+#define FWLJMET_LJMet_interface_AllocationProfiler_h
+
+/*
+ Heap accounting around selector stages and calculators.
+ Reads the allocator's own counters at scope entry and exit: the per-thread
+ allocated/deallocated byte counters of jemalloc (the cmsRun default) when it is
+ loaded, otherwise the glibc arena usage, which only gives the net change.
+ Before glibc 2.33 the arena usage comes from mallinfo, whose int fields wrap at 4 GB:
+ changes are then taken modulo 2^32 and a warning is printed once a wrap is seen.
+ Only entry and exit are sampled: memory allocated and freed inside a call shows up in the
+ jemalloc allocated bytes, but never in the net or retained figures, which are not peaks.
+ Counters stay in plain integers; TH1s are only created at EndJob.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "CommonTools/UtilAlgos/interface/TFileDirectory.h"
+
+class AllocationProfiler {
+public:
+    struct Sample {
+        uint64_t allocated;   // cumulative bytes allocated by this thread (jemalloc only)
+        uint64_t deallocated; // cumulative bytes freed by this thread (jemalloc only)
+        long long inUse;      // live heap bytes
+    };
+
+    AllocationProfiler();
+    ~AllocationProfiler() { }
+
+    /// True when the allocator gives per-thread allocated bytes, not only the net change
+    bool HasByteCounters() const { return mbJemalloc; }
+
+    /// Book a probe, returns its id. Registering the same group/name twice returns the same id.
+    unsigned int Register(std::string const & group, std::string const & name);
+
+    Sample Now() const;
+    /// Account the heap activity since start to probe id
+    void Stop(unsigned int id, Sample const & start);
+
+    /// Accounts the enclosing scope; does nothing without a profiler
+    class Scope {
+    public:
+        Scope(AllocationProfiler * profiler, unsigned int id): mpProfiler(profiler), mId(id) { if (mpProfiler) mStart = mpProfiler->Now(); }
+        ~Scope() { if (mpProfiler) mpProfiler->Stop(mId, mStart); }
+    private:
+        AllocationProfiler * mpProfiler;
+        unsigned int mId;
+        Sample mStart;
+    };
+
+    /// Per-call bytes histogram for each probe, in a subdirectory per group
+    void Write(TFileDirectory & dir) const;
+    /// Calls, bytes allocated, net and largest retained growth per probe
+    void Print(std::ostream & out) const;
+
+private:
+    struct Probe {
+        std::string group;
+        std::string name;
+        unsigned long long nCalls;
+        unsigned long long bytesAllocated;
+        long long netBytes;     // live bytes left behind, summed over calls
+        long long maxRetainedBytes; // largest live growth left at the exit of a single call, not an in-call peak
+        std::vector<unsigned long long> counts; // underflow, nBins, overflow
+    };
+
+    std::string mLegend;
+    std::vector<Probe> mvProbes;
+
+    // jemalloc mallctl, looked up at run time so there is no link dependency
+    typedef int (*MallctlByMib)(const size_t *, size_t, void *, size_t *, void *, size_t);
+    bool mbJemalloc;
+    MallctlByMib mpMallctlByMib;
+    size_t mAllocatedMib[2];
+    size_t mDeallocatedMib[2];
+
+    // 32-bit mallinfo counters wrapped during the job
+    bool mbWrapped;
+
+    // log10(bytes per call) binning: 1 B to 10 GB
+    static const int nBins = 100;
+    static constexpr double xMin = 0.0;
+    static constexpr double xMax = 10.0;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef FWLJMET_LJMet_interface_AngularMatcher_h
+#define FWLJMET_LJMet_interface_AngularMatcher_h
+
+/*
+ Nearest-neighbour matching in (eta, phi).
+ Targets are added once, kept sorted in eta, and queried with a dR cutoff;
+ only targets inside the eta window are visited and dR is compared squared.
+ Targets are identified by the order they were added in; equal distances go to the lower index.
+ */
+
+#include <iostream>
+#include <vector>
+
+class AngularMatcher {
+public:
+    AngularMatcher() : mSorted(true) { }
+    ~AngularMatcher() { }
+
+    void Clear() { mvTargets.clear(); mSorted = true; }
+    /// Add a target, returns its index
+    unsigned int Add(double eta, double phi);
+    unsigned int size() const { return mvTargets.size(); }
+
+    /// Index of the nearest target with dR < dRMax, -1 if none. dR2 is set to its squared distance.
+    int Nearest(double eta, double phi, double dRMax, double & dR2);
+    int Nearest(double eta, double phi, double dRMax) { double dR2; return Nearest(eta, phi, dRMax, dR2); }
+
+    /// Indices of all targets with dR < dRMax, ascending
+    void Within(double eta, double phi, double dRMax, std::vector<unsigned int> & out);
+
+private:
+    struct Target {
+        double eta;
+        double phi;
+        unsigned int index;
+        bool operator<(Target const & other) const { return eta < other.eta; }
+    };
+
+    void sort();
+
+    std::vector<Target> mvTargets;
+    bool mSorted;
+};
+
+#endif
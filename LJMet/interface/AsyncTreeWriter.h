@@ -0,0 +1,110 @@
+#ifndef FWLJMET_LJMet_interface_AsyncTreeWriter_h
+#define FWLJMET_LJMet_interface_AsyncTreeWriter_h
+
+/*
+ TTree::Fill (basket compression and file writes) on a dedicated writer thread.
+ The tree branches point to back buffers owned by the writer, bound to the event content
+ values (front) when the branches are created. Push copies the front values into a free
+ snapshot and queues it; the writer moves each snapshot into the back buffers and fills.
+ There are 'depth' snapshots, queued or being written: Push blocks when they are all taken.
+ Vectors are swapped, not copied, on the writer side so their capacity circulates.
+
+ The writer thread writes baskets into the TFileService file outside the "TFileService" shared
+ resource that serializes LJMet::analyze. That is only safe while no other module of the job
+ writes to that file during the event loop, i.e. LJMet owns the only TTree in it: histograms of
+ other modules live in memory until TFileService closes the file, after LJMet::endJob has called
+ Finish. This holds for the runFWLJMet_*.py configurations; otherwise leave asyncQueueDepth at 0.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+class AsyncTreeWriter {
+public:
+    /// fill is called on the writer thread once the back buffers hold an event
+    AsyncTreeWriter(unsigned int depth, std::function<void()> fill);
+    ~AsyncTreeWriter();
+
+    /// Back buffer for a front value, stable address to give to TTree::Branch. Only before the first Push.
+    template<class T> T * Bind(T const & front) { return std::get<Columns<T>>(mColumns).Bind(front); }
+
+    /// Queue a copy of the front values, blocks while the queue is full
+    void Push();
+    /// Write the queued events and stop the writer thread; rethrows a writer failure
+    void Finish();
+
+    /// Events queued and written, and time the event thread spent waiting for a free snapshot
+    void Print(std::ostream & out) const;
+
+private:
+    template<class T> struct Columns {
+        std::vector<T const *> vFront;
+        std::deque<T> back; // deque: addresses stay valid as columns are added
+
+        T * Bind(T const & front) {
+            vFront.push_back(&front);
+            back.emplace_back();
+            return &back.back();
+        }
+        void Take(std::vector<T> & snapshot) const {
+            snapshot.resize(vFront.size());
+            for (unsigned int i = 0; i < vFront.size(); ++i) snapshot[i] = *vFront[i];
+        }
+        void Give(std::vector<T> & snapshot) {
+            for (unsigned int i = 0; i < snapshot.size(); ++i) assign(back[i], snapshot[i]);
+        }
+    };
+
+    // scalars are copied, vectors swapped
+    template<class T> static void assign(T & back, T & snapshot) { back = snapshot; }
+    static void assign(bool & back, std::vector<bool>::reference snapshot) { back = snapshot; }
+    template<class T> static void assign(std::vector<T> & back, std::vector<T> & snapshot) { back.swap(snapshot); }
+
+    // one column set per branch type of LjmetEventContent
+    typedef std::tuple<Columns<bool>, Columns<int>, Columns<long long>, Columns<double>, Columns<float>,
+                       Columns<std::vector<bool>>, Columns<std::vector<int>>, Columns<std::vector<double>>,
+                       Columns<std::vector<float>>, Columns<std::vector<std::string>>> ColumnSet;
+    typedef std::tuple<std::vector<bool>, std::vector<int>, std::vector<long long>, std::vector<double>, std::vector<float>,
+                       std::vector<std::vector<bool>>, std::vector<std::vector<int>>, std::vector<std::vector<double>>,
+                       std::vector<std::vector<float>>, std::vector<std::vector<std::string>>> Snapshot;
+
+    template<std::size_t... I> void take(Snapshot & snapshot, std::index_sequence<I...>) const {
+        (std::get<I>(mColumns).Take(std::get<I>(snapshot)), ...);
+    }
+    template<std::size_t... I> void give(Snapshot & snapshot, std::index_sequence<I...>) {
+        (std::get<I>(mColumns).Give(std::get<I>(snapshot)), ...);
+    }
+
+    void run();
+    void rethrow();
+
+    std::string mLegend;
+    std::function<void()> mFill;
+    ColumnSet mColumns;
+
+    std::mutex mMutex;
+    std::condition_variable mFreeCondition;  // a snapshot was returned
+    std::condition_variable mQueueCondition; // a snapshot was queued, or finishing
+    std::vector<std::unique_ptr<Snapshot>> mvFree;
+    std::deque<std::unique_ptr<Snapshot>> mQueue;
+    bool mbDone;
+    std::string mError;
+    std::thread mThread;
+
+    unsigned long long mnQueued;
+    unsigned long long mnWritten;
+    unsigned long long mnBlocked;
+    std::chrono::steady_clock::duration mBlockedTime;
+};
+
+#endif
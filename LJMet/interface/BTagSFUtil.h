@@ -68,6 +68,16 @@ public:
                      int shiftflag = 0,
                      bool subjetflag = false);
 
+    // same, seeding the scale factor random numbers from seedPhi instead of jet.phi(),
+    // e.g. the phi of the corrected jet when jet is the uncorrected source jet
+    bool isJetTagged(const pat::Jet &jet,
+                     double seedPhi,
+                     TLorentzVector correctedJet_lv,
+                     edm::Event const & event,
+                     bool isMc,
+                     int shiftflag = 0,
+                     bool subjetflag = false);
+
 
     
 private:
@@ -16,9 +16,9 @@
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/ConsumesCollector.h"
 
+#include "FWLJMET/LJMet/interface/LjmetEventContent.h"
 
 class BaseEventSelector;
-class LjmetEventContent;
 
 namespace edm {
     class EventBase;
@@ -45,20 +45,27 @@ public:
     std::string mLegend;
     
     // LJMET event content setters
-    /// Declare a new histogram to be created for the module
-    void SetHistogram(std::string name, int nbins, double low, double high);
+    /// Declare a new histogram to be created for the module, the handle is for filling it in the event loop
+    LjmetEventContent::HistHandle SetHistogram(std::string name, int nbins, double low, double high);
+    LjmetEventContent::HistHandle SetHistogram2D(std::string name, int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh);
+    void FillHist(LjmetEventContent::HistHandle hist, double value, double weight = 1.0) { mpEc->FillHist(hist, value, weight); }
+    void FillHist2D(LjmetEventContent::HistHandle hist, double x, double y, double weight = 1.0) { mpEc->FillHist2D(hist, x, y, weight); }
     void SetHistValue(std::string name, double value);
     void SetValue(std::string name, bool value);
     void SetValue(std::string name, int value);
     void SetValue(std::string name, long long value);
     void SetValue(std::string name, double value);
-    void SetValue(std::string name, std::vector<bool> value);
-    void SetValue(std::string name, std::vector<int> value);
-    void SetValue(std::string name, std::vector<double> value);
-    void SetValue(std::string name, std::vector<std::string> value);
+    void SetValue(std::string name, std::vector<bool> const & value);
+    void SetValue(std::string name, std::vector<int> const & value);
+    void SetValue(std::string name, std::vector<double> const & value);
+    void SetValue(std::string name, std::vector<std::string> const & value);
+
+    /// Selector collections read by this calculator (BaseEventSelector::Collection), declared in BeginJob
+    std::vector<int> const & GetUses() const { return mvUses; }
 
 protected:
     edm::ParameterSet mPset;
+    void DeclareUse(int collection) { mvUses.push_back(collection); }
     
 private:
     /// Private init method to be called by LjmetFactory when registering the calculator
@@ -67,6 +74,7 @@ private:
     void SetEventContent(LjmetEventContent * pEc) { mpEc = pEc; }
     void SetPSet(edm::ParameterSet pset) { mPset = pset; }
     LjmetEventContent * mpEc;
+    std::vector<int> mvUses;
 };
 
 #endif
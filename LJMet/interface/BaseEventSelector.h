@@ -18,6 +18,13 @@
 #include "FWCore/Framework/interface/Event.h"
 
 #include "FWLJMET/LJMet/interface/LjmetEventContent.h"
+#include "FWLJMET/LJMet/interface/AK8FeatureCache.h"
+#include "FWLJMET/LJMet/interface/GenParticleIndex.h"
+#include "FWLJMET/LJMet/interface/LHESummary.h"
+#include "FWLJMET/LJMet/interface/CorrectedJet.h"
+#include "FWLJMET/LJMet/interface/Type1MET.h"
+#include "FWLJMET/LJMet/interface/LatencyProfiler.h"
+#include "FWLJMET/LJMet/interface/AllocationProfiler.h"
 
 #include "PhysicsTools/SelectorUtils/interface/EventSelector.h"
 
@@ -51,6 +58,12 @@ public:
     virtual void AnalyzeEvent( edm::EventBase const & event, LjmetEventContent & ec ) { }
     std::string GetName() { return mName; }
 
+    //Collections built on first access in the event. Calculators declare the ones they read in BeginJob,
+    //collections nobody reads are never built.
+    enum Collection { kSelCorrJets, kSelCorrJetsAK8, kCorrectedMet, nCollections };
+    void DeclareUse(Collection collection);
+    bool IsDeclared(Collection collection) const { return mbDeclared[collection]; }
+
     // -----------------------------------------------------------------------------------------------------------------------------------------
     // Note: below probably needs to be recoded so it can be written in individual Selectors, but still accessible to different calculators -start
     // -----------------------------------------------------------------------------------------------------------------------------------------
@@ -71,18 +84,33 @@ public:
     //Jets
     std::vector<edm::Ptr<pat::Jet>>      const & GetAllJets()      const { return vAllJets; }
     std::vector<edm::Ptr<pat::Jet>>      const & GetSelJets()      const { return vSelJets; }
-    std::vector<pat::Jet>                const & GetSelCorrJets()  const { return vSelCorrJets; }
+    std::vector<CorrectedJet>            const & GetSelCorrJetRecords() const { return vSelCorrJetRecords; } // parallel to GetSelJets()
+    std::vector<pat::Jet>                const & GetSelCorrJets()           { require(kSelCorrJets); return vSelCorrJets; } // pat::Jet copies, built from the records
     std::vector<edm::Ptr<pat::Jet>>      const & GetSelBtagJets()  const { return vSelBtagJets; }
     std::vector<std::pair<TLorentzVector, bool>>         const & GetSelCorrJetsWithBTags() const { return vSelCorrJetsWithBTags; }
-    std::vector<pat::Jet>                const & GetSelCorrJetsAK8()  const { return vSelCorrJets_AK8; }
+    std::vector<pat::Jet>                const & GetSelCorrJetsAK8()        { require(kSelCorrJetsAK8); return vSelCorrJets_AK8; }
+    AK8FeatureCache                            & GetAK8Features()           { require(kSelCorrJetsAK8); return mAK8Features; } // lazily filled, parallel to GetSelCorrJetsAK8()
 
     //MET
-    edm::Ptr<pat::MET>                   const & GetMet()          const { return pMet; }
-    TLorentzVector                       const & GetCorrectedMet() const { return correctedMET_p4; }
+    edm::Ptr<pat::MET>                   const & GetMet()                   { require(kCorrectedMet); return pMet; }
+    TLorentzVector                       const & GetCorrectedMet()          { require(kCorrectedMet); return correctedMET_p4; }
+    Type1MET                             const & GetType1MET()              { require(kCorrectedMet); return mType1MET; } // per-jet deltas behind GetCorrectedMet(), for the other MET flavours
 
     //PV
     std::vector<edm::Ptr<reco::Vertex>>  const & GetSelPVs()       const { return vSelPVs; }
 
+    //Gen particles: index built by the first calculator asking for it in the event
+    GenParticleIndex const & GetGenParticleIndex(edm::Handle<reco::GenParticleCollection> const & genParticles) {
+        if(!mGenParticleIndex.IsBuilt(genParticles.id())) mGenParticleIndex.Build(genParticles);
+        return mGenParticleIndex;
+    }
+
+    //LHE: outgoing parton summary, built by the first calculator asking for it in the event
+    LHESummary const & GetLHESummary(edm::Handle<LHEEventProduct> const & lheEvent) {
+        if(!mLHESummary.IsBuilt(lheEvent.id())) mLHESummary.Build(lheEvent);
+        return mLHESummary;
+    }
+
     // -----------------------------------------------------------------------------------------------------------------------------------------
     // Note: above probably needs to be recoded so it can be written in individual Selectors, but still accessible to different calculators - end
     // -----------------------------------------------------------------------------------------------------------------------------------------
@@ -92,18 +120,57 @@ public:
     void SetMc(bool isMc) { mbIsMc = isMc; }
     bool IsMc() { return mbIsMc; }
 
+    /// Stage timing, set before BeginJob; null when timing is off
+    void SetProfiler(LatencyProfiler * profiler) { mpProfiler = profiler; }
+    /// Stage heap accounting, set before BeginJob; null when off
+    void SetAllocationProfiler(AllocationProfiler * profiler) { mpAllocProfiler = profiler; }
+
     // LJMET event content setters
     void Init( void );
     void SetEventContent(LjmetEventContent * pEc) { mpEc = pEc; }
 
     /// Declare a new histogram to be created for the module
-    void SetHistogram(std::string name, int nbins, double low, double high) { mpEc->SetHistogram(mName, name, nbins, low, high); }
+    LjmetEventContent::HistHandle SetHistogram(std::string name, int nbins, double low, double high) { return mpEc->SetHistogram(mName, name, nbins, low, high); }
+    LjmetEventContent::HistHandle SetHistogram2D(std::string name, int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh) {
+        return mpEc->SetHistogram2D(mName, name, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh);
+    }
     void SetHistValue(std::string name, double value) { mpEc->SetHistValue(mName, name, value); }
     void FillHist(std::string name, double value) { mpEc->FillHist(mName, name, value); }
+    void FillHist(LjmetEventContent::HistHandle hist, double value, double weight = 1.0) { mpEc->FillHist(hist, value, weight); }
+    void FillHist2D(LjmetEventContent::HistHandle hist, double x, double y, double weight = 1.0) { mpEc->FillHist2D(hist, x, y, weight); }
+
+    /// Cut flow by handle: cuts are registered once in BeginJob, the event loop then works on indices only
+    typedef unsigned int CutHandle;
+    /// New strbitset cut (as push_back), counted in the cut flow printed by print()
+    CutHandle RegisterCut(std::string const & name);
+    /// Cut-flow step without a strbitset bit, only histogrammed (e.g. a group of cuts)
+    CutHandle RegisterCutStep(std::string const & name);
+    /// Book the cut-flow histogram of a cut, named after it
+    void SetCutHistogram(CutHandle cut, int nbins = 2, double low = 0, double high = 2);
+    /// Set the bit, count it and fill 1 into the histogram of the cut if booked
+    void PassCut(pat::strbitset & ret, CutHandle cut);
+    void FillCutHist(CutHandle cut, double value);
+    bool ConsiderCut(CutHandle cut) const { return considerCut(mvCuts[cut].index); }
+    bool IgnoreCut(CutHandle cut) const { return ignoreCut(mvCuts[cut].index); }
+    /// strbitset index of a cut, for cut(CutIndex(cut), int()) and friends
+    index_type const & CutIndex(CutHandle cut) const { return mvCuts[cut].index; }
 
 
 protected:
 
+    /// Build a lazy collection for the current event (mpEvent). Selectors that fill it eagerly need not override.
+    virtual void BuildCollection(Collection collection) { }
+    /// Mark a lazy collection as filled for this event, e.g. when the selection itself needed it
+    void SetBuilt(Collection collection) { mbBuilt[collection] = true; }
+    /// Current event, set by the selector for lazy building
+    edm::Event const * mpEvent;
+
+    LatencyProfiler * mpProfiler;
+    AllocationProfiler * mpAllocProfiler;
+
+    /// Events before any selection, filled with the sign of the generator weight
+    CutHandle mEventsCut;
+
     // -----------------------------------------------------------------------------------------------------------------------------------------
     // Note: below probably needs to be recoded so it can be written in individual Selectors, but still accessible to different calculators -start
     // -----------------------------------------------------------------------------------------------------------------------------------------
@@ -124,18 +191,27 @@ protected:
     //Jets
     std::vector<edm::Ptr<pat::Jet>>      vAllJets;
     std::vector<edm::Ptr<pat::Jet>>      vSelJets;
+    std::vector<CorrectedJet>            vSelCorrJetRecords;
     std::vector<pat::Jet>                vSelCorrJets;
     std::vector<edm::Ptr<pat::Jet>>      vSelBtagJets;
     std::vector<std::pair<TLorentzVector, bool>> vSelCorrJetsWithBTags;
     std::vector<pat::Jet>                vSelCorrJets_AK8;
+    AK8FeatureCache                      mAK8Features;
 
     //MET
     edm::Ptr<pat::MET>     pMet;
     TLorentzVector         correctedMET_p4;
+    Type1MET               mType1MET;
 
     //PV
     std::vector<edm::Ptr<reco::Vertex>>  vSelPVs;
 
+    //Gen particles
+    GenParticleIndex                     mGenParticleIndex;
+
+    //LHE
+    LHESummary                           mLHESummary;
+
     // -----------------------------------------------------------------------------------------------------------------------------------------
     // Note: above probably needs to be recoded so it can be written in individual Selectors, but still accessible to different calculators - end
     // -----------------------------------------------------------------------------------------------------------------------------------------
@@ -158,6 +234,20 @@ private:
     /// Do what any event selector must do after event processing is done, but before event content gets saved to file
     void EndEvent(edm::EventBase const & event, LjmetEventContent & ec);
 
+    /// Build a lazy collection on its first access in the event
+    void require(Collection collection);
+    bool mbDeclared[nCollections];
+    bool mbBuilt[nCollections];
+    bool mbWarned[nCollections];
+
+    struct CutEntry {
+        std::string name;                      // printout only
+        index_type index;                      // strbitset bit, unused for steps
+        int flowIndex;                         // position in the Selector cut flow, -1 for steps
+        LjmetEventContent::HistHandle hist;    // booked histogram, -1 if none
+    };
+    std::vector<CutEntry> mvCuts;
+
 };
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef FWLJMET_LJMet_interface_BranchPrecision_h
+#define FWLJMET_LJMet_interface_BranchPrecision_h
+
+/*
+ Reduced-precision storage of double and std::vector<double> branches.
+ Rules come from the precision VPSet of the treeOutput PSet, first match wins:
+   pattern  branch name, shell wildcards (fnmatch), e.g. "theJetDaughter*" or "*Eta*"
+   mode     "float"    : stored as float
+            "mantissa" : float with the mantissa rounded to 'bits' bits (1-23)
+            "fixed"    : 'bits'-bit fixed point on [min, max], clamped, stored as float
+ A matched branch is written as /F or std::vector<float>, so reading it back takes a float address.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+class BranchPrecision {
+public:
+    enum Mode { kFloat = 0, kMantissa, kFixed };
+
+    struct Rule {
+        std::string pattern;
+        Mode mode;
+        int bits;
+        double min;
+        double max;
+        unsigned int nMatched; // branches, for the printout
+    };
+
+    BranchPrecision();
+    ~BranchPrecision() { }
+
+    void Configure(std::vector<edm::ParameterSet> const & vRules);
+    bool Empty() const { return mvRules.empty(); }
+
+    /// Rule for a branch name, null if it keeps double precision
+    Rule const * Match(std::string const & name);
+
+    static float Reduce(double value, Rule const & rule);
+
+    /// Branches matched per rule
+    void Print(std::ostream & out) const;
+
+private:
+    std::string mLegend;
+    std::vector<Rule> mvRules;
+};
+
+#endif
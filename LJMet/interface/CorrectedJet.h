@@ -0,0 +1,38 @@
+#ifndef FWLJMET_LJMet_interface_CorrectedJet_h
+#define FWLJMET_LJMet_interface_CorrectedJet_h
+
+/*
+ Lightweight record of a corrected jet: where it sits in the source collection,
+ its corrected four-momentum and the factors that produced it.
+ Selectors keep these instead of corrected pat::Jet copies; the PAT content
+ (discriminators, constituents, gen match) is read from the source jet.
+ */
+
+#include "DataFormats/Candidate/interface/Candidate.h"
+
+struct CorrectedJet {
+
+    CorrectedJet(): index(0), jecL1(1), jec(1), jer(1), unc(1), cleaned(false) { }
+
+    /// position of the jet in the source collection
+    unsigned int index;
+
+    /// fully corrected four-momentum, as used by the selection
+    reco::Candidate::LorentzVector p4;
+
+    /// JES applied to the raw (lepton-cleaned) jet: L1 only and the full chain
+    float jecL1;
+    float jec;
+    /// JER smearing and JEC uncertainty scale applied on top of the JES
+    float jer;
+    float unc;
+
+    /// lepton constituents were removed before correcting
+    bool cleaned;
+
+    double pt()  const { return p4.pt(); }
+    double eta() const { return p4.eta(); }
+    double phi() const { return p4.phi(); }
+};
+
+#endif
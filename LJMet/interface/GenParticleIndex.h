@@ -0,0 +1,52 @@
+#ifndef FWLJMET_LJMet_interface_GenParticleIndex_h
+#define FWLJMET_LJMet_interface_GenParticleIndex_h
+
+/*
+ Per-event index of the generator record, built once and shared by all MC calculators.
+ Holds |pdgId| and status buckets, the only lookups the calculators make. All index lists are
+ in ascending collection order, so looping over them visits particles in the same order as
+ looping over the collection.
+ */
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+
+#include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/Provenance/interface/ProductID.h"
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+
+class GenParticleIndex {
+public:
+    GenParticleIndex();
+    ~GenParticleIndex() { }
+
+    /// Forget the current event, the next Get() rebuilds
+    void Reset() { mpParticles = 0; }
+    bool IsBuilt(edm::ProductID const & id) const { return mpParticles != 0 && mProductId == id; }
+    void Build(edm::Handle<reco::GenParticleCollection> const & genParticles);
+
+    reco::GenParticleCollection const & Particles() const { return *mpParticles; }
+    unsigned int size() const { return mpParticles ? mpParticles->size() : 0; }
+
+    /// Indices of particles with the given |pdgId| / status
+    std::vector<unsigned int> const & WithAbsPdgId(int absPdgId) const;
+    std::vector<unsigned int> const & WithStatus(int status) const;
+
+    /// Merged, ascending, duplicate-free indices over several |pdgId| / status buckets
+    void SelectAbsPdgIds(std::vector<int> const & absPdgIds, std::vector<unsigned int> & out) const;
+    void SelectStatuses(std::vector<int> const & statuses, std::vector<unsigned int> & out) const;
+
+private:
+    void merge(std::vector<std::vector<unsigned int> const *> const & buckets, std::vector<unsigned int> & out) const;
+
+    reco::GenParticleCollection const * mpParticles;
+    edm::ProductID mProductId;
+
+    // buckets are kept (and cleared) across events so their storage is reused
+    std::unordered_map<int, std::vector<unsigned int> > mmByAbsPdgId;
+    std::unordered_map<int, std::vector<unsigned int> > mmByStatus;
+    std::vector<unsigned int> mvEmpty;
+};
+
+#endif
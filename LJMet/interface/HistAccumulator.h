@@ -0,0 +1,95 @@
+#ifndef FWLJMET_LJMet_interface_HistAccumulator_h
+#define FWLJMET_LJMet_interface_HistAccumulator_h
+
+/*
+ Bin arrays behind the histograms booked in LjmetEventContent.
+ Every thread fills its own slot: one contiguous block of (entries, sum w, sum w^2 per bin)
+ for all histograms, padded to whole cache lines so two slots never share one.
+ Fills take no lock and touch no TH1; Merge adds all slots into the TFileService
+ histograms at EndJob.
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TH1.h"
+
+class HistAccumulator {
+public:
+    HistAccumulator();
+    ~HistAccumulator() { }
+
+    /// Book the bins of a histogram (nbinsy = 0 for 1D), returns its index.
+    /// Throws once a thread has filled: its slot is already sized.
+    int Book(int nbinsx, double xmin, double xmax, int nbinsy = 0, double ymin = 0, double ymax = 0);
+
+    void Fill(int hist, double x, double w = 1.0) {
+        Slot & slot = slotOfThread();
+        if (slot.shared) { std::lock_guard<std::mutex> lock(mSharedMutex); add(slot, hist, bin(hist, x), w); }
+        else add(slot, hist, bin(hist, x), w);
+    }
+    void Fill2D(int hist, double x, double y, double w = 1.0) {
+        Slot & slot = slotOfThread();
+        if (slot.shared) { std::lock_guard<std::mutex> lock(mSharedMutex); add(slot, hist, bin(hist, x, y), w); }
+        else add(slot, hist, bin(hist, x, y), w);
+    }
+
+    /// Add the content of all slots to h, booked with the same binning, and clear them. Not concurrent with fills.
+    void Merge(int hist, TH1 * h);
+
+    /// Threads beyond this many share one locked slot
+    static const unsigned int nMaxSlots = 64;
+
+private:
+    struct Axis {
+        int nbins;
+        double min;
+        double max;
+    };
+    struct Layout {
+        Axis x;
+        Axis y;             // nbins = 0 for 1D
+        unsigned int nBins; // including under/overflow
+        unsigned int offset;
+    };
+    struct Slot {
+        Slot(unsigned int nDoubles, bool isShared);
+        std::vector<double> storage; // over-allocated by one cache line, data is aligned inside it
+        double * data;
+        bool shared;
+    };
+
+    /// Same as TAxis::FindFixBin: NaN goes to the overflow
+    static int axisBin(Axis const & axis, double x) {
+        if (x < axis.min) return 0;
+        if (!(x < axis.max)) return axis.nbins+1;
+        return 1 + (int)(axis.nbins*(x-axis.min)/(axis.max-axis.min));
+    }
+    unsigned int bin(int hist, double x) const { return axisBin(mvLayout[hist].x, x); }
+    unsigned int bin(int hist, double x, double y) const {
+        Layout const & layout = mvLayout[hist];
+        return axisBin(layout.x, x) + (layout.x.nbins+2)*axisBin(layout.y, y);
+    }
+    /// block of a histogram: entries, then (sum w, sum w^2) per bin
+    void add(Slot & slot, int hist, unsigned int bin, double w) const {
+        double * block = slot.data + mvLayout[hist].offset;
+        block[0]       += 1;
+        block[1+2*bin] += w;
+        block[2+2*bin] += w*w;
+    }
+
+    Slot & slotOfThread();
+
+    std::vector<Layout> mvLayout;
+    unsigned int mnDoubles;
+
+    std::unique_ptr<Slot> mSlots[nMaxSlots];
+    std::unique_ptr<Slot> mSharedSlot;
+    std::atomic<bool> mbSlotCreated;
+    std::mutex mSlotMutex;   // slot creation
+    std::mutex mSharedMutex; // fills of the shared slot
+};
+
+#endif
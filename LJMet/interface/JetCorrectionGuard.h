@@ -0,0 +1,62 @@
+#ifndef FWLJMET_LJMet_interface_JetCorrectionGuard_h
+#define FWLJMET_LJMet_interface_JetCorrectionGuard_h
+
+/*
+ Range-checked front-end to FactorizedJetCorrector and JetCorrectionUncertainty.
+ (eta, pt) is checked against the eta binning of the parameters before evaluating,
+ so a jet outside the correction range gets a status code instead of an exception.
+ Failures are counted per kind; only the first few are printed as they happen,
+ the totals are printed at EndJob.
+ */
+
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
+#include "CondFormats/JetMETObjects/interface/FactorizedJetCorrector.h"
+#include "CondFormats/JetMETObjects/interface/JetCorrectionUncertainty.h"
+
+class JetCorrectionGuard {
+public:
+    enum Status { kOk = 0, kBadInput, kEtaOutOfRange, kException, nStatus };
+    enum Kind { kJES = 0, kUncertainty, nKinds };
+
+    /// eta range covered by every level of a corrector, [etaMin, etaMax)
+    struct Domain {
+        Domain(): etaMin(-std::numeric_limits<float>::max()), etaMax(std::numeric_limits<float>::max()) { }
+        float etaMin;
+        float etaMax;
+    };
+    static Domain MakeDomain(std::vector<JetCorrectorParameters> const & vPar);
+    static Domain MakeDomain(JetCorrectorParameters const & par);
+
+    JetCorrectionGuard();
+    ~JetCorrectionGuard() { }
+
+    void SetLegend(std::string const & legend) { mLegend = legend; }
+
+    /// getSubCorrections() of the corrector; on failure corrVec is {1}, i.e. the jet stays uncorrected
+    Status SubCorrections(FactorizedJetCorrector & corrector, Domain const & domain,
+                          double eta, double pt, double area, double rho,
+                          std::vector<float> & corrVec);
+    /// getUncertainty(up); on failure unc is 0
+    Status Uncertainty(JetCorrectionUncertainty & jecUnc, Domain const & domain,
+                       double eta, double pt, bool up, double & unc);
+
+    /// Failed evaluations per kind and status, nothing if all succeeded
+    void Print(std::ostream & out) const;
+
+private:
+    Status check(Domain const & domain, double eta, double pt) const;
+    void count(Kind kind, Status status, double eta, double pt);
+
+    std::string mLegend;
+    unsigned long long mCounts[nKinds][nStatus];
+
+    // failures printed one by one before only being counted
+    static const unsigned int nMaxPrint = 5;
+};
+
+#endif
@@ -6,6 +6,9 @@
 
 #include "FWLJMET/LJMet/interface/BaseEventSelector.h"
 #include "FWLJMET/LJMet/interface/LjmetFactory.h"
+#include "FWLJMET/LJMet/interface/CorrectedJet.h"
+#include "FWLJMET/LJMet/interface/Type1MET.h"
+#include "FWLJMET/LJMet/interface/JetCorrectionGuard.h"
 
 
 #include "DataFormats/PatCandidates/interface/Jet.h"
@@ -32,6 +35,12 @@ class JetMETCorrHelper{
 
         void SetFacJetCorr(edm::EventBase const & event);
 
+        /// isMc and the correction files, equal for two helpers that correct jets the same way
+        std::string const & ConfigKey() const { return mConfigKey; }
+
+        /// Summary of the jets that could not be corrected (out of range), to be called at EndJob
+        void PrintWarnings(std::ostream & out) const { mGuard.Print(out); }
+
         TLorentzVector correctJet(const pat::Jet & jet,
                                                   edm::Event const & event,
                                                   edm::EDGetTokenT<double> rhoJetsToken,
@@ -47,15 +56,37 @@ class JetMETCorrHelper{
                                         bool reCorrectJet=false,
                                         unsigned int syst=0);
 
+        /// Correct a jet once and keep only the result: p4 and factors.
+        /// rawP4 is the uncorrected jet, after lepton cleaning if cleaned is set.
+        CorrectedJet correctJetRecord(const pat::Jet & jet,
+                                      unsigned int index,
+                                      const reco::Candidate::LorentzVector & rawP4,
+                                      bool cleaned,
+                                      edm::Event const & event,
+                                      edm::EDGetTokenT<double> rhoJetsToken,
+                                      bool doAK8Corr=false,
+                                      bool reCorrectJet=false,
+                                      unsigned int syst=0);
+
         TLorentzVector correctMet(const pat::MET & met,
                                   edm::Event const & event,
                                   edm::EDGetTokenT<double> rhoJetsToken,
-                                  std::vector<edm::Ptr<pat::Jet>> vAllJets,
+                                  std::vector<edm::Ptr<pat::Jet>> const & vAllJets,
                                   bool reCorrectjet = false,
                                   unsigned int syst = 0,
                                   bool useHF = true);
 
 
+        /// Type-1 deltas of all jets, each jet corrected once: syst and, if allSyst, the four shifts.
+        /// type1.Apply(met, v, useHF) then gives correctMet(met, ..., reCorrectjet, v, useHF) for every MET flavour.
+        void correctMetType1(edm::Event const & event,
+                             edm::EDGetTokenT<double> rhoJetsToken,
+                             std::vector<edm::Ptr<pat::Jet>> const & vAllJets,
+                             bool reCorrectjet,
+                             unsigned int syst,
+                             bool allSyst,
+                             Type1MET & type1);
+
         TLorentzVector correctJetForMet(const pat::Jet & jet,
                                         edm::Event const & event,
                                         edm::EDGetTokenT<double> rhoJetsToken,
@@ -63,12 +94,29 @@ class JetMETCorrHelper{
 
     private:
 
+        double getRho(edm::Event const & event, edm::EDGetTokenT<double> rhoJetsToken);
+
+        /// JES on record.p4 (no-op unless reCorrectJet), then JER smearing and JEC uncertainty (MC only)
+        void applyJES(const pat::Jet & jet, double eta, double pt_raw, double rho,
+                      bool doAK8Corr, bool reCorrectJet, CorrectedJet & record);
+        void applyJERAndUnc(const pat::Jet & jet, double eta, double phi, double rho,
+                            bool doAK8Corr, unsigned int syst, CorrectedJet & record);
+
+        /// Muon-subtracted (L1 - L123) x JER x JEC-unc of one jet for the wanted variations, zero for the others
+        void metDeltas(const pat::Jet & jet, double rho,
+                       bool const (&want)[Type1MET::nVariations],
+                       TLorentzVector (&delta)[Type1MET::nVariations]);
+        double jerScaleForMet(const pat::Jet & jet, const TLorentzVector & jetP4, double res, double factor);
+        double jecUncForMet(const TLorentzVector & jetP4, double ptscale, bool up);
+
         bool debug;
 
         bool isMc;
 
         std::string mLegend = "\t[JetMETCorrHelper]: ";
 
+        std::string mConfigKey;
+
         TRandom3 JERrand;
 
 	std::shared_ptr<JetCorrectionUncertainty> jecUnc;
@@ -82,18 +130,33 @@ class JetMETCorrHelper{
 	std::shared_ptr<FactorizedJetCorrector> JetCorrector;
 	std::shared_ptr<FactorizedJetCorrector> JetCorrectorAK8;
 
+        // range checks in front of the correctors, with the failure counters
+        JetCorrectionGuard mGuard;
+        JetCorrectionGuard::Domain mJetCorrectorDomain;
+        JetCorrectionGuard::Domain mJetCorrectorAK8Domain;
+        JetCorrectionGuard::Domain mJecUncDomain;
+
         std::map<std::string,std::string> mJetParStr;
 
-        std::map<std::string, std::vector<JetCorrectorParameters> > mEraVPar;
-        std::map<std::string, std::vector<JetCorrectorParameters> > mEraVParAK8;
         std::map<std::string, std::shared_ptr<JetCorrectorParameters>> mStrJetCorPar;
 
-        std::map<std::string, std::map<std::string, std::shared_ptr<JetCorrectorParameters> > > mEra_mStrJetCorPar;
         std::map<std::string, std::map<std::string, std::string>>              mEraJetParStr;
-        std::map<std::string, std::string> mEraReplaceStr;
 
-        std::map<std::string, std::shared_ptr<FactorizedJetCorrector> > mEraFacJetCorr;
-        std::map<std::string, std::shared_ptr<FactorizedJetCorrector> > mEraFacJetCorrAK8;
+        /// Run range of a data era and its correctors, built on the first event of the era
+        struct EraIOV {
+            std::string era;
+            unsigned int firstRun;
+            unsigned int lastRun;
+            std::shared_ptr<FactorizedJetCorrector> corrector;
+            std::shared_ptr<FactorizedJetCorrector> correctorAK8;
+            JetCorrectionGuard::Domain domain;
+            JetCorrectionGuard::Domain domainAK8;
+        };
+        void addEraIOV(std::string const & era, std::string const & replaceStr, unsigned int lastRun);
+        void loadEra(EraIOV & iov);
+
+        std::vector<EraIOV> vEraIOV; // sorted by run
+        int mCurrentIOV = -1;        // era of the previous call to SetFacJetCorr
 
 };
 
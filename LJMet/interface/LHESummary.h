@@ -0,0 +1,44 @@
+#ifndef FWLJMET_LJMet_interface_LHESummary_h
+#define FWLJMET_LJMet_interface_LHESummary_h
+
+/*
+ Per-event summary of the outgoing LHE partons (status 1 quarks and gluons),
+ computed once directly over the HEPEUP arrays and shared by all calculators.
+ */
+
+#include <iostream>
+
+#include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/Provenance/interface/ProductID.h"
+#include "SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h"
+
+class LHESummary {
+public:
+    LHESummary();
+    ~LHESummary() { }
+
+    /// Forget the current event, the next Get() rebuilds
+    void Reset() { mBuilt = false; }
+    bool IsBuilt(edm::ProductID const & id) const { return mBuilt && mProductId == id; }
+    void Build(edm::Handle<LHEEventProduct> const & lheEvent);
+
+    /// Scalar pt sum and multiplicity of the outgoing partons
+    double HT() const { return mHT; }
+    int NPartons() const { return mNPartons; }
+    int NB() const { return mNB; }
+    int NC() const { return mNC; }
+    /// pt of the hardest outgoing parton, 0 if none
+    double LeadingPartonPt() const { return mLeadingPartonPt; }
+
+private:
+    bool mBuilt;
+    edm::ProductID mProductId;
+
+    double mHT;
+    int mNPartons;
+    int mNB;
+    int mNC;
+    double mLeadingPartonPt;
+};
+
+#endif
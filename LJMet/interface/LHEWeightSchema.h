@@ -0,0 +1,54 @@
+#ifndef FWLJMET_LJMet_interface_LHEWeightSchema_h
+#define FWLJMET_LJMet_interface_LHEWeightSchema_h
+
+/*
+ Layout of the LHE event weights, resolved once per run.
+ The weight ids are parsed and matched against the configured id ranges on the first event
+ of a run or when the weights no longer match the layout, e.g. a new input file in MC run 1.
+ Every event checks a cheap fingerprint (count, first and last id); all ids are compared only
+ when the run changes. Otherwise an event only copies the kept weights.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SimDataFormats/GeneratorProducts/interface/WeightsInfo.h"
+
+class LHEWeightSchema {
+public:
+    LHEWeightSchema();
+    ~LHEWeightSchema() { }
+
+    /// Keep only weights with id in one of the inclusive ranges [ranges[2k], ranges[2k+1]]; empty keeps all
+    void SetKeepRanges(std::vector<int> const & ranges);
+
+    /// Resolve the layout on a new run or if the weights do not match it
+    void Update(unsigned int run, std::vector<gen::WeightsInfo> const & weights);
+
+    /// Integer ids of the kept weights, in output order
+    std::vector<int> const & Ids() const { return mvIds; }
+
+    /// Kept weights divided by norm, in the order of Ids()
+    void Fill(std::vector<gen::WeightsInfo> const & weights, double norm, std::vector<double> & out) const;
+
+private:
+    /// Same count, first and last id as the layout
+    bool fingerprintMatches(std::vector<gen::WeightsInfo> const & weights) const;
+    /// Same ids, in the same order, as the layout
+    bool matches(std::vector<gen::WeightsInfo> const & weights) const;
+    void resolve(std::vector<gen::WeightsInfo> const & weights);
+    bool keep(int id) const;
+
+    std::string mLegend;
+    std::vector<std::pair<int, int> > mvKeepRanges;
+
+    bool mResolved;
+    unsigned int mRun;
+    std::vector<std::string> mvAllIds; // ids the layout was resolved with, in input order
+
+    std::vector<unsigned int> mvSlots;
+    std::vector<int> mvIds;
+};
+
+#endif
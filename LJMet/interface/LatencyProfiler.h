@@ -0,0 +1,69 @@
+#ifndef FWLJMET_LJMet_interface_LatencyProfiler_h
+#define FWLJMET_LJMet_interface_LatencyProfiler_h
+
+/*
+ Low-overhead wall-clock timers for the event loop.
+ Each timer keeps a log10(ns) latency histogram in plain counters; TH1s are
+ only created at EndJob, one directory per group (selector stages, calculators).
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CommonTools/UtilAlgos/interface/TFileDirectory.h"
+
+class LatencyProfiler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    LatencyProfiler();
+    ~LatencyProfiler() { }
+
+    /// Book a timer, returns its id. Registering the same group/name twice returns the same id.
+    unsigned int Register(std::string const & group, std::string const & name);
+
+    static Clock::time_point Now() { return Clock::now(); }
+    /// Record the time elapsed since start for timer id
+    void Stop(unsigned int id, Clock::time_point const & start) { add(id, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()); }
+    /// Same for a batch of nCalls back-to-back calls, booked as nCalls calls of the mean latency
+    void Stop(unsigned int id, Clock::time_point const & start, unsigned long long nCalls) { add(id, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(), nCalls); }
+
+    /// Times the enclosing scope; does nothing without a profiler
+    class Scope {
+    public:
+        Scope(LatencyProfiler * profiler, unsigned int id): mpProfiler(profiler), mId(id) { if (mpProfiler) mStart = Clock::now(); }
+        ~Scope() { if (mpProfiler) mpProfiler->Stop(mId, mStart); }
+    private:
+        LatencyProfiler * mpProfiler;
+        unsigned int mId;
+        Clock::time_point mStart;
+    };
+
+    /// One histogram per timer, in a subdirectory per group
+    void Write(TFileDirectory & dir) const;
+    /// Calls, mean and total time and throughput per timer
+    void Print(std::ostream & out) const;
+
+private:
+    struct Timer {
+        std::string group;
+        std::string name;
+        unsigned long long nCalls;
+        double totalNs;
+        std::vector<unsigned long long> counts; // underflow, nBins, overflow
+    };
+
+    void add(unsigned int id, long long ns, unsigned long long nCalls = 1);
+
+    std::string mLegend;
+    std::vector<Timer> mvTimers;
+
+    // log10(latency/ns) binning: 100 ns to 10 s
+    static const int nBins = 160;
+    static constexpr double xMin = 2.0;
+    static constexpr double xMax = 10.0;
+};
+
+#endif
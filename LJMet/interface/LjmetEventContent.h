@@ -11,10 +11,17 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
 #include <limits>
 #include "TH1.h"
 #include "TTree.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWLJMET/LJMet/interface/HistAccumulator.h"
+#include "FWLJMET/LJMet/interface/TreeOutputTuning.h"
+#include "FWLJMET/LJMet/interface/BranchPrecision.h"
+#include "FWLJMET/LJMet/interface/AsyncTreeWriter.h"
+
+class LatencyProfiler;
 
 class LjmetEventContent {
 public:
@@ -26,17 +33,39 @@ public:
         mNBins(nbins),
         mXMin(xmin),
         mXMax(xmax),
+        mNBinsY(0),
+        mYMin(0),
+        mYMax(0),
+        mpHist(0),
+        mValue(std::numeric_limits<double>::max()),
+        mHandle(-1) { }
+
+        HistMetadata(std::string name, int nbinsx, double xmin, double xmax, int nbinsy, double ymin, double ymax):
+        mName(name),
+        mNBins(nbinsx),
+        mXMin(xmin),
+        mXMax(xmax),
+        mNBinsY(nbinsy),
+        mYMin(ymin),
+        mYMax(ymax),
         mpHist(0),
-        mValue(std::numeric_limits<double>::max()) { }
+        mValue(std::numeric_limits<double>::max()),
+        mHandle(-1) { }
         
         ~HistMetadata() { }
         std::string GetName() { return mName; }
         int GetNBins() { return mNBins; }
         double GetXMin() { return mXMin; }
         double GetXMax() { return mXMax; }
+        bool Is2D() { return mNBinsY > 0; }
+        int GetNBinsY() { return mNBinsY; }
+        double GetYMin() { return mYMin; }
+        double GetYMax() { return mYMax; }
         TH1 * GetHist() { return mpHist; }
         double GetValue() { return mValue; }
+        int GetHandle() { return mHandle; }
         void SetHist(TH1 * pHist){ mpHist = pHist; }
+        void SetHandle(int handle) { mHandle = handle; }
         void SetValue(double value) { mValue = value; }
         
     private:
@@ -45,8 +74,12 @@ public:
         int mNBins;
         double mXMin;
         double mXMax;
+        int mNBinsY; // 0 for 1D histograms
+        double mYMin;
+        double mYMax;
         TH1 * mpHist;
         double mValue;
+        int mHandle;
     };
     
     LjmetEventContent();
@@ -55,35 +88,62 @@ public:
     LjmetEventContent(const LjmetEventContent &); // stop default
     
     void SetVerbosity(int verbosity);
+    /// Output tree I/O settings (TreeOutputTuning) and reduced precision rules (BranchPrecision), before SetTree
+    void SetOutputTuning(edm::ParameterSet const & pset);
     void SetTree(TTree * tree);
+    /// Write throughput and compression per branch, if asked for in the output settings
+    void PrintOutputReport(std::ostream & out) const { if (mTuning.Report() && mpTree) mTuning.Print(out, mpTree); }
     
-    /// Create histogram entry in event content, so it is created by the LjmetFactory
-    void SetHistogram(std::string modname, std::string histname, int nbins, double low, double high);
+    /// Index of a booked histogram, for filling without name lookups
+    typedef int HistHandle;
+
+    /// Create histogram entry in event content, so it is created by the LjmetFactory.
+    /// Booking an existing name returns the handle of the existing entry.
+    HistHandle SetHistogram(std::string modname, std::string histname, int nbins, double low, double high);
+    HistHandle SetHistogram2D(std::string modname, std::string histname,
+                              int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh);
     
     void SetValue(std::string key, bool value);
     void SetValue(std::string key, int value);
     void SetValue(std::string key, long long value);
     void SetValue(std::string key, double value);
-    void SetValue(std::string key, std::vector<bool> value);
-    void SetValue(std::string key, std::vector<int> value);
-    void SetValue(std::string key, std::vector<double> value);
-    void SetValue(std::string key, std::vector<std::string> value);
+    void SetValue(std::string key, std::vector<bool> const & value);
+    void SetValue(std::string key, std::vector<int> const & value);
+    void SetValue(std::string key, std::vector<double> const & value);
+    void SetValue(std::string key, std::vector<std::string> const & value);
     // histograms: mDoubleHist[module][histname]
     // actual histograms get created by TFileService in the main application
     // based on info in this container
     std::map<std::string, std::map<std::string, HistMetadata>> & GetHistMap() { return mDoubleHist; }
     
-    /// Assign current hist value to hist metadata collection
+    /// Assign current hist value to hist metadata collection, filled through the handle by Fill()
     void SetHistValue(std::string modname, std::string histname, double value);
-    void FillHist(std::string modname, std::string histname, double value);
+    /// Fill by name, one map lookup per call; prefer the handle versions in the event loop
+    void FillHist(std::string modname, std::string histname, double value, double weight = 1.0);
+
+    /// Fills go to per-thread bin arrays, no lock and no TH1 involved; MergeHists moves them to the histograms
+    void FillHist(HistHandle hist, double value, double weight = 1.0) { mHists.Fill(hist, value, weight); }
+    void FillHist2D(HistHandle hist, double x, double y, double weight = 1.0) { mHists.Fill2D(hist, x, y, weight); }
+    /// Add the accumulated fills to the histograms created by LJMet, at EndJob
+    void MergeHists();
+    /// Histogram behind a handle, null until LJMet has created it; holds the fills after MergeHists
+    TH1 * GetHist(HistHandle hist) { return mvHist[hist]->GetHist(); }
     void Fill();
+    /// TTree::Fill runs on a writer thread (asyncQueueDepth > 0), Fill then only queues the event
+    bool IsAsync() const { return (bool)mpWriter; }
+    /// Time each TTree::Fill with timer id of profiler, on whichever thread runs it; null to stop
+    void SetWriteTimer(LatencyProfiler * profiler, unsigned int id) { mpWriteProfiler = profiler; mWriteTimer = id; }
+    /// With asyncQueueDepth > 0 Fill only queues the event: writes what is queued and stops the writer thread, at EndJob
+    void FinishTree();
     
 private:
     /// Create branches in the tree according to maps
     int createBranches();
+    HistHandle book(std::string const & modname, std::string const & histname, HistMetadata const & hist);
     std::string mName;
     std::string mLegend;
     TTree * mpTree;
+    TreeOutputTuning mTuning;
 
     
     std::map<std::string,bool> mBoolBranch;
@@ -94,10 +154,41 @@ private:
     std::map<std::string,std::vector<int> > mVectorIntBranch;
     std::map<std::string,std::vector<double> > mVectorDoubleBranch;
     std::map<std::string,std::vector<std::string> > mVectorStringBranch;
+
+    // float copies of the double branches matched by a precision rule, these are what gets written
+    struct ReducedBranch {
+        double const * source;
+        float * target;
+        BranchPrecision::Rule const * rule;
+    };
+    struct ReducedVectorBranch {
+        std::vector<double> const * source;
+        std::vector<float> * target;
+        BranchPrecision::Rule const * rule;
+    };
+    BranchPrecision mPrecision;
+    std::map<std::string,float> mReducedDoubleBranch;
+    std::map<std::string,std::vector<float> > mReducedVectorDoubleBranch;
+    std::vector<ReducedBranch> mvReducedBranch;
+    std::vector<ReducedVectorBranch> mvReducedVectorBranch;
+    void reducePrecision();
+
+    // TTree::Fill on a writer thread (asyncQueueDepth > 0): branches then point to its back buffers
+    std::unique_ptr<AsyncTreeWriter> mpWriter;
+    template<class T> T * branchAddress(T & front) { return mpWriter ? mpWriter->Bind(front) : &front; }
+    void fillTree();
     // mDoubleHist[module][histname]=value
     std::map<std::string,std::map<std::string,HistMetadata> > mDoubleHist;
+    // handle -> entry of mDoubleHist, map nodes never move
+    std::vector<HistMetadata *> mvHist;
+    // bins of mvHist, same indices
+    HistAccumulator mHists;
+    // handles given a value by SetHistValue since the last Fill()
+    std::vector<HistHandle> mvHistValueSet;
     bool mFirstEntry;
     int mVerbosity;
+    LatencyProfiler * mpWriteProfiler;
+    unsigned int mWriteTimer;
 };
 
 #endif
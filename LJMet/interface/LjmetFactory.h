@@ -12,6 +12,8 @@
 #include "FWLJMET/LJMet/interface/BaseCalc.h"
 #include "FWLJMET/LJMet/interface/BaseEventSelector.h"
 #include "FWLJMET/LJMet/interface/LjmetEventContent.h"
+#include "FWLJMET/LJMet/interface/LatencyProfiler.h"
+#include "FWLJMET/LJMet/interface/AllocationProfiler.h"
 
 class LjmetFactory {
 public:
@@ -25,6 +27,9 @@ public:
     
     /// Return pointer to registered event selector. Exit if not found
     BaseEventSelector * GetEventSelector(std::string name);
+
+    /// Return pointer to registered calculator, 0 if not found
+    BaseCalc * GetCalculator(std::string name);
     
     /// Loop over all registered calculators and compute implemented variables
     void RunAllCalculators(edm::Event const & event, BaseEventSelector * selector, LjmetEventContent & ec, std::vector<std::string> vIncl);
@@ -35,6 +40,11 @@ public:
     /// Set each calc's parameter set, if present
     void SetAllCalcConfig(edm::ParameterSet const Par, std::vector<std::string> vIncl);
     void SetExcludedCalcs(std::vector<std::string> vExcl);
+
+    /// Time each calculator's ProduceEvent and AnalyzeEvent, set before BeginJobAllCalc
+    void SetProfiler(LatencyProfiler * profiler) { mpProfiler = profiler; }
+    /// Account the heap activity of each calculator's ProduceEvent and AnalyzeEvent, set before BeginJobAllCalc
+    void SetAllocationProfiler(AllocationProfiler * profiler) { mpAllocProfiler = profiler; }
     
     /// Run all BeginJob()'s
     void BeginJobAllCalc(edm::ConsumesCollector && iC, std::vector<std::string> vIncl);
@@ -52,6 +62,12 @@ private:
     std::map<std::string, BaseEventSelector * > mpSelectors;
     BaseEventSelector * theSelector;
     std::vector<std::string> mvExcludedCalcs;
+    LatencyProfiler * mpProfiler;
+    std::map<std::string, unsigned int> mProduceTimers;
+    std::map<std::string, unsigned int> mAnalyzeTimers;
+    AllocationProfiler * mpAllocProfiler;
+    std::map<std::string, unsigned int> mProduceAllocProbes;
+    std::map<std::string, unsigned int> mAnalyzeAllocProbes;
     static LjmetFactory * instance;
 };
 
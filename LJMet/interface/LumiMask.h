@@ -0,0 +1,54 @@
+#ifndef FWLJMET_LJMet_interface_LumiMask_h
+#define FWLJMET_LJMet_interface_LumiMask_h
+
+/*
+ Certified run/lumi ranges from a golden JSON ({"run": [[first, last], ...], ...}, e.g. FWLJMET/LJMet/data/json/Cert_*_JSON.txt).
+ Runs are kept sorted with their merged lumi ranges in one flat array, so a lookup is two binary
+ searches; the decision is cached for the current lumi block, which makes it O(1) for all its events.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class LumiMask {
+public:
+    LumiMask();
+    ~LumiMask() { }
+
+    /// Parse the JSON file, throws cms::Exception if it cannot be read
+    void Load(std::string const & path);
+    bool Empty() const { return mvRuns.empty(); }
+
+    bool Contains(unsigned int run, unsigned int lumi) {
+        if (run != mCachedRun || lumi != mCachedLumi) {
+            mCachedRun      = run;
+            mCachedLumi     = lumi;
+            mCachedDecision = lookup(run, lumi);
+        }
+        return mCachedDecision;
+    }
+
+    /// Runs and lumi sections certified
+    void Print(std::ostream & out) const;
+
+private:
+    struct Range {
+        unsigned int first;
+        unsigned int last;
+    };
+
+    bool lookup(unsigned int run, unsigned int lumi) const;
+
+    std::string mLegend;
+
+    std::vector<unsigned int> mvRuns;  // sorted
+    std::vector<unsigned int> mvFirst; // ranges of mvRuns[i]: mvRanges[mvFirst[i]] to mvRanges[mvFirst[i+1]]
+    std::vector<Range> mvRanges;
+
+    unsigned int mCachedRun;
+    unsigned int mCachedLumi;
+    bool mCachedDecision;
+};
+
+#endif
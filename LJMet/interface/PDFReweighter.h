@@ -0,0 +1,78 @@
+#ifndef FWLJMET_LJMet_interface_PDFReweighter_h
+#define FWLJMET_LJMet_interface_PDFReweighter_h
+
+/*
+ PDF reweighting from a base set to all members of a new set.
+ The base central member and every member of the new set are loaded once at BeginJob
+ and kept resident for the job; per event only the xfxQ evaluations are done.
+
+ When all members of the new set are log-bicubic grids on the same knots, their grids are
+ also copied into one array per subgrid and flavour with the members innermost. The
+ interpolation cell is then located once per (x, Q) and all members are interpolated in a
+ single sweep, reproducing LHAPDF's LogBicubicInterpolator. Points outside the grid
+ (extrapolation) and other sets go through PDF::xfxQ2 member by member, as does everything
+ with LHAPDF >= 6.3, which no longer exposes the per-flavour grids (KnotArray1F).
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace LHAPDF {
+    class PDF;
+}
+
+class PDFReweighter {
+public:
+    PDFReweighter();
+    ~PDFReweighter();
+
+    /// Load the base central member and all members of the new set
+    void Initialize(std::string const & basePDFname, std::string const & newPDFname);
+    bool IsInitialized() const { return mpBase != 0; }
+    unsigned int size() const { return mvMembers.size(); }
+
+    /// Weight of every new member relative to the base for the incoming partons (id1, x1) and (id2, x2) at scale Q.
+    /// base is the base-set product f1(x1)*f2(x2), the same for all members.
+    void Evaluate(int id1, double x1, int id2, double x2, double Q,
+                  std::vector<double> & weights, double & base);
+
+private:
+    // knots of one flavour in one subgrid; xf is [ix][iq2][member]
+    struct FlavourGrid {
+        std::vector<double> xs;
+        std::vector<double> logxs;
+        std::vector<double> q2s;
+        std::vector<double> logq2s;
+        std::vector<double> xf;
+    };
+    struct Subgrid {
+        double q2Low;
+        std::map<int, FlavourGrid> flavours;
+    };
+
+    void clear();
+    bool buildGrids();
+    /// xf(id, x, q2) for all members, false if the point is not covered by the grids
+    bool sweep(int id, double x, double q2, std::vector<double> & xf);
+    void cubicInX(FlavourGrid const & grid, size_t ix, size_t iq2, double tlogx, std::vector<double> & out) const;
+
+    std::string mLegend;
+    LHAPDF::PDF * mpBase;
+    std::vector<LHAPDF::PDF *> mvMembers;
+
+    bool mBatched;
+    std::vector<Subgrid> mvSubgrids;
+    std::vector<int> mvForcePositive;
+
+    // per-event scratch, sized to the number of members
+    std::vector<double> mvXf1;
+    std::vector<double> mvXf2;
+    std::vector<double> mvVll;
+    std::vector<double> mvVl;
+    std::vector<double> mvVh;
+    std::vector<double> mvVhh;
+};
+
+#endif
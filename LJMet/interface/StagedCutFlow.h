@@ -0,0 +1,58 @@
+#ifndef FWLJMET_LJMet_interface_StagedCutFlow_h
+#define FWLJMET_LJMet_interface_StagedCutFlow_h
+
+/*
+ Ordered selection stages, run until the first one that fails.
+ Selectors register cheap stages first so failing events never reach the expensive
+ object building; every stage counts the events it saw and the events it passed.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "FWCore/Framework/interface/Event.h"
+#include "PhysicsTools/SelectorUtils/interface/strbitset.h"
+
+#include "FWLJMET/LJMet/interface/LatencyProfiler.h"
+#include "FWLJMET/LJMet/interface/AllocationProfiler.h"
+
+class StagedCutFlow {
+public:
+    typedef std::function<bool(edm::Event const &, pat::strbitset &)> Stage;
+
+    StagedCutFlow(): mpProfiler(0), mpAllocProfiler(0) { }
+    ~StagedCutFlow() { }
+
+    /// Time every stage added afterwards, histograms go to group
+    void SetProfiler(LatencyProfiler * profiler, std::string const & group) { mpProfiler = profiler; mGroup = group; }
+    /// Account the heap activity of every stage added afterwards
+    void SetAllocationProfiler(AllocationProfiler * profiler, std::string const & group) { mpAllocProfiler = profiler; mGroup = group; }
+
+    void Add(std::string const & name, Stage stage);
+    unsigned int size() const { return mvStages.size(); }
+
+    /// Run the stages in order, stopping at the first failure. True if all stages passed.
+    bool Run(edm::Event const & event, pat::strbitset & ret);
+
+    /// Per-stage table of events seen and passed
+    void Print(std::ostream & out, std::string const & legend) const;
+
+private:
+    struct Entry {
+        std::string name;
+        Stage stage;
+        unsigned long long nSeen;
+        unsigned long long nPassed;
+        unsigned int timer;
+        unsigned int allocProbe;
+    };
+    std::vector<Entry> mvStages;
+
+    LatencyProfiler * mpProfiler;
+    AllocationProfiler * mpAllocProfiler;
+    std::string mGroup;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef FWLJMET_LJMet_interface_TreeOutputTuning_h
+#define FWLJMET_LJMet_interface_TreeOutputTuning_h
+
+/*
+ I/O settings of the LJMet output tree, from the untracked treeOutput PSet of the LJMet module:
+   compressionAlgorithm  "ZLIB", "LZMA", "LZ4" or "ZSTD" (ROOT >= 6.20); empty keeps the file setting
+   compressionLevel      0-9, -1 keeps the file setting
+   autoFlush             TTree::SetAutoFlush: > 0 entries, < 0 bytes per cluster; 0 keeps the ROOT default
+   basketSizeEvents      size baskets per branch group after this many events, 0 keeps the ROOT defaults
+   basketSizeMin/Max     bounds of those basket sizes, bytes
+   report                write throughput and compression per branch at EndJob
+ Branch groups are the branch types of LjmetEventContent (bool, int, ..., vector<double>).
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TTree.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+class TreeOutputTuning {
+public:
+    TreeOutputTuning();
+    ~TreeOutputTuning() { }
+
+    void Configure(edm::ParameterSet const & pset);
+    bool Report() const { return mbReport; }
+
+    /// Tree-wide settings, when the tree is set
+    void ApplyToTree(TTree * tree);
+    /// Compression of a new branch, recorded in its group
+    void AddBranch(TTree * tree, std::string const & name, std::string const & group);
+
+    /// After each TTree::Fill: basket sizing once basketSizeEvents entries are in, timing for the report
+    void AfterFill(TTree * tree, std::chrono::steady_clock::duration fillTime);
+
+    /// Compressed and uncompressed bytes per branch and group, and write throughput
+    void Print(std::ostream & out, TTree * tree) const;
+
+private:
+    struct Branch {
+        std::string name;
+        int group;
+    };
+
+    void sizeBaskets(TTree * tree);
+
+    std::string mLegend;
+
+    int mCompression; // ROOT compression settings, 100*algorithm + level; -1 unchanged
+    long long mAutoFlush;
+    unsigned int mBasketSizeEvents;
+    int mBasketSizeMin;
+    int mBasketSizeMax;
+    bool mbReport;
+
+    std::vector<std::string> mvGroups;
+    std::vector<Branch> mvBranches;
+    bool mbBasketsSized;
+    double mFillSeconds;
+};
+
+#endif
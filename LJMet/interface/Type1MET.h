@@ -0,0 +1,79 @@
+#ifndef FWLJMET_LJMet_interface_Type1MET_h
+#define FWLJMET_LJMet_interface_Type1MET_h
+
+/*
+ Type-1 MET corrections of one event, all variations from a single pass over the jets.
+ JetMETCorrHelper::correctMetType1 stores the (L1 - L123) x JER x JEC-unc delta of each jet
+ once per variation; every MET flavour (nominal, shifted, no-HF, modified) is then the
+ uncorrected MET plus a sum over these shared deltas.
+ Variations are indexed by the usual syst code: 0 nominal, 1 JECup, 2 JECdown, 3 JERup, 4 JERdown.
+ The deltas are only valid for a corrector with the same ConfigKey and rho input tag (SameCorrection).
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "DataFormats/PatCandidates/interface/MET.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+
+#include "TLorentzVector.h"
+
+struct Type1MET {
+
+    enum Variation { kNominal = 0, kJECup, kJECdown, kJERup, kJERdown, nVariations };
+
+    struct JetDelta {
+        bool central; // |eta| <= 2.6, the jets kept when HF is not used
+        double px[nVariations];
+        double py[nVariations];
+    };
+
+    Type1MET(): reCorrected(false) { for (int v = 0; v < nVariations; v++) computed[v] = false; }
+
+    void Reset(bool reCorrect) {
+        reCorrected = reCorrect;
+        for (int v = 0; v < nVariations; v++) computed[v] = false;
+        vJets.clear();
+    }
+
+    /// Corrector (JetMETCorrHelper::ConfigKey) and rho the deltas are computed with, set once by the owner
+    void SetSource(std::string const & configKey, edm::InputTag const & rho) {
+        corrector = configKey;
+        rhoTag    = rho;
+    }
+
+    bool Has(unsigned int v) const { return v < nVariations && computed[v]; }
+
+    /// The deltas were computed with reCorrect, a corrector with this ConfigKey and this rho
+    bool SameCorrection(bool reCorrect, std::string const & configKey, edm::InputTag const & rho) const {
+        return reCorrected == reCorrect && rhoTag == rho && corrector == configKey;
+    }
+
+    /// Same as JetMETCorrHelper::correctMet(met, ..., syst = v, useHF): the uncorrected MET plus the jet deltas,
+    /// or met itself if the jets were not re-corrected
+    TLorentzVector Apply(pat::MET const & met, unsigned int v, bool useHF = true) const {
+        double px = met.px();
+        double py = met.py();
+        if (reCorrected) {
+            px = met.uncorPx();
+            py = met.uncorPy();
+            for (auto const & jet : vJets) {
+                if (!useHF && !jet.central) continue;
+                px += jet.px[v];
+                py += jet.py[v];
+            }
+        }
+        TLorentzVector p4;
+        p4.SetPxPyPzE(px, py, 0, std::sqrt(px*px+py*py));
+        return p4;
+    }
+
+    bool reCorrected;
+    std::string corrector;  // JetMETCorrHelper::ConfigKey of the helper that computed the deltas
+    edm::InputTag rhoTag;   // rho used, tokens of different consumers differ for the same tag
+    bool computed[nVariations];
+    std::vector<JetDelta> vJets;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "FWLJMET/LJMet/interface/AK8FeatureCache.h"
+#include "FWLJMET/LJMet/interface/JetMETCorrHelper.h"
+#include "FWLJMET/LJMet/interface/BTagSFUtil.h"
+
+#include <cmath>
+
+
+AK8FeatureCache::AK8FeatureCache():
+    mLegend("\t[AK8FeatureCache]: "),
+    mpJetMETCorr(0),
+    mpBtagSfUtil(0),
+    mReCorrectJet(false),
+    mSyst(0),
+    mIsMc(false),
+    mpEvent(0),
+    mpJets(0)
+{
+}
+
+
+void AK8FeatureCache::Initialize(JetMETCorrHelper * jetMETCorr,
+                                 BTagSFUtil * btagSfUtil,
+                                 edm::EDGetTokenT<double> rhoJetsToken,
+                                 bool reCorrectJet,
+                                 unsigned int syst,
+                                 bool isMc)
+{
+    std::cout << mLegend << "Initializing AK8FeatureCache object." << std::endl;
+
+    mpJetMETCorr  = jetMETCorr;
+    mpBtagSfUtil  = btagSfUtil;
+    mRhoJetsToken = rhoJetsToken;
+    mReCorrectJet = reCorrectJet;
+    mSyst         = syst;
+    mIsMc         = isMc;
+}
+
+
+void AK8FeatureCache::Reset(edm::Event const & event, std::vector<pat::Jet> const & jets)
+{
+    mpEvent = &event;
+    mpJets  = &jets;
+
+    // keep the per-jet vectors around so their capacity is reused event to event
+    if(mvFeatures.size() < jets.size()) mvFeatures.resize(jets.size());
+    for(unsigned int i = 0; i < mvFeatures.size(); ++i) mvFeatures[i].filled = false;
+    mvFeatures.resize(jets.size());
+}
+
+
+double AK8FeatureCache::ConstituentChargeSum(unsigned int i, double kappa)
+{
+    JetFeatures const & features = Get(i);
+    if(features.chargeSumKappa == kappa) return features.chargeSum;
+
+    double sumWeightedCharge = 0.0;
+    for(auto const & con : features.chargedConstituents){
+        sumWeightedCharge = sumWeightedCharge + ( con.first * pow(con.second,kappa) );
+    }
+
+    mvFeatures[i].chargeSumKappa = kappa;
+    mvFeatures[i].chargeSum      = sumWeightedCharge;
+    return sumWeightedCharge;
+}
+
+
+void AK8FeatureCache::fill(unsigned int i)
+{
+    pat::Jet const & jet = mpJets->at(i);
+    JetFeatures & features = mvFeatures[i];
+
+    features.nDaughters        = jet.numberOfDaughters();
+    features.softDropMassPuppi = (double)jet.userFloat("ak8PFJetsPuppiSoftDropMass");
+    features.tau1              = (double)jet.userFloat("NjettinessAK8Puppi:tau1");
+    features.tau2              = (double)jet.userFloat("NjettinessAK8Puppi:tau2");
+    features.tau3              = (double)jet.userFloat("NjettinessAK8Puppi:tau3");
+
+    // Charged constituents for the jet charge; neutrals contribute nothing to sum(q*pt^kappa)
+    features.chargedConstituents.clear();
+    for(unsigned int iCon = 0, nCon = jet.numberOfDaughters(); iCon < nCon; ++iCon){
+        reco::Candidate const * con = jet.daughter(iCon);
+        if(con == 0 || con->charge() == 0) continue;
+        features.chargedConstituents.push_back(std::make_pair((int)con->charge(), (double)con->pt()));
+    }
+    features.chargeSumKappa = std::nan("");
+    features.chargeSum      = 0.0;
+
+    // Soft drop subjets: raw sum for the puppi SD mass, corrected kinematics and b-tags per subjet
+    TLorentzVector jetP4;
+    jetP4.SetPtEtaPhiE(jet.pt(), jet.eta(), jet.phi(), jet.energy());
+
+    features.softDropRawP4.SetPtEtaPhiE(0, 0, 0, 0);
+    features.subjets.clear();
+
+    if(!jet.hasSubjets("SoftDropPuppi")){
+        features.filled = true;
+        return;
+    }
+
+    auto const & sdSubjets = jet.subjets("SoftDropPuppi");
+    features.subjets.reserve(sdSubjets.size());
+    for(auto const & it : sdSubjets){
+
+        TLorentzVector rawSubjet;
+        rawSubjet.SetPtEtaPhiM(it->correctedP4(0).pt(),it->correctedP4(0).eta(),it->correctedP4(0).phi(),it->correctedP4(0).mass());
+        features.softDropRawP4 += rawSubjet;
+
+        SubjetFeatures subjet;
+        subjet.subjet        = it;
+        subjet.csvv2         = it->bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
+        subjet.hadronFlavour = it->hadronFlavour();
+
+        if(mpJetMETCorr){
+            bool isAK8 = false;
+            pat::Jet corrsubjet = mpJetMETCorr->correctJetReturnPatJet(*it, *mpEvent, mRhoJetsToken, isAK8, mReCorrectJet, mSyst);
+            subjet.pt   = corrsubjet.pt();
+            subjet.eta  = corrsubjet.eta();
+            subjet.phi  = corrsubjet.phi();
+            subjet.mass = corrsubjet.mass();
+        }
+        else{
+            subjet.pt   = it->pt();
+            subjet.eta  = it->eta();
+            subjet.phi  = it->phi();
+            subjet.mass = it->mass();
+        }
+
+        // correction only rescales the p4, tags depend on discriminators, flavour and phi: use the original subjet
+        for(int shift = 0; shift < 5; ++shift){
+            subjet.btag[shift] = mpBtagSfUtil ? mpBtagSfUtil->isJetTagged(*it, jetP4, *mpEvent, mIsMc, shift, true) : false;
+        }
+
+        features.subjets.push_back(subjet);
+    }
+
+    features.filled = true;
+}
@@ -0,0 +1,153 @@
+#include "FWLJMET/LJMet/interface/AllocationProfiler.h"
+
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <dlfcn.h>
+#include <malloc.h>
+
+#include "TH1F.h"
+
+// mallinfo2 (size_t fields) replaces mallinfo (int fields) from glibc 2.33
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define ALLOCATIONPROFILER_MALLINFO2
+#endif
+
+
+const int AllocationProfiler::nBins;
+constexpr double AllocationProfiler::xMin;
+constexpr double AllocationProfiler::xMax;
+
+
+AllocationProfiler::AllocationProfiler():
+    mLegend("\t[AllocationProfiler]: "),
+    mbJemalloc(false),
+    mpMallctlByMib(0),
+    mbWrapped(false)
+{
+    typedef int (*MallctlNameToMib)(const char *, size_t *, size_t *);
+    MallctlNameToMib nameToMib = (MallctlNameToMib)dlsym(RTLD_DEFAULT, "mallctlnametomib");
+    mpMallctlByMib = (MallctlByMib)dlsym(RTLD_DEFAULT, "mallctlbymib");
+
+    if (nameToMib && mpMallctlByMib){
+        size_t allocatedLen = 2, deallocatedLen = 2;
+        mbJemalloc = nameToMib("thread.allocated", mAllocatedMib, &allocatedLen) == 0
+                  && nameToMib("thread.deallocated", mDeallocatedMib, &deallocatedLen) == 0;
+    }
+
+    if (mbJemalloc) std::cout << mLegend << "using the jemalloc per-thread byte counters" << std::endl;
+    else std::cout << mLegend << "jemalloc not found, only the net heap change from mallinfo is available" << std::endl;
+}
+
+
+unsigned int AllocationProfiler::Register(std::string const & group, std::string const & name)
+{
+    for (unsigned int i = 0; i < mvProbes.size(); i++){
+        if (mvProbes[i].group == group && mvProbes[i].name == name) return i;
+    }
+
+    Probe probe;
+    probe.group          = group;
+    probe.name           = name;
+    probe.nCalls         = 0;
+    probe.bytesAllocated = 0;
+    probe.netBytes       = 0;
+    probe.maxRetainedBytes = 0;
+    probe.counts.assign(nBins+2, 0);
+    mvProbes.push_back(probe);
+
+    return mvProbes.size()-1;
+}
+
+
+AllocationProfiler::Sample AllocationProfiler::Now() const
+{
+    Sample sample = {0, 0, 0};
+
+    if (mbJemalloc){
+        size_t len = sizeof(uint64_t);
+        mpMallctlByMib(mAllocatedMib, 2, &sample.allocated, &len, 0, 0);
+        len = sizeof(uint64_t);
+        mpMallctlByMib(mDeallocatedMib, 2, &sample.deallocated, &len, 0, 0);
+        sample.inUse = (long long)sample.allocated - (long long)sample.deallocated;
+    }
+    else {
+#ifdef ALLOCATIONPROFILER_MALLINFO2
+        struct mallinfo2 info = mallinfo2();
+        sample.inUse = (long long)info.uordblks + (long long)info.hblkhd;
+#else
+        // live bytes modulo 2^32, Stop unwraps the difference
+        struct mallinfo info = mallinfo();
+        sample.inUse = (uint32_t)((uint32_t)info.uordblks + (uint32_t)info.hblkhd);
+#endif
+    }
+
+    return sample;
+}
+
+
+void AllocationProfiler::Stop(unsigned int id, Sample const & start)
+{
+    Sample stop = Now();
+    Probe & probe = mvProbes[id];
+
+    long long net = stop.inUse - start.inUse;
+#ifndef ALLOCATIONPROFILER_MALLINFO2
+    if (!mbJemalloc){
+        // exact as long as a single call changes the heap by less than 2 GB
+        long long unwrapped = (int32_t)(uint32_t)net;
+        if (unwrapped != net) mbWrapped = true;
+        net = unwrapped;
+    }
+#endif
+    unsigned long long allocated = mbJemalloc ? stop.allocated - start.allocated : (net > 0 ? net : 0);
+
+    probe.nCalls++;
+    probe.bytesAllocated += allocated;
+    probe.netBytes       += net;
+    if (net > probe.maxRetainedBytes) probe.maxRetainedBytes = net;
+
+    int bin = 0; // underflow, also for nothing allocated
+    if (allocated > 0){
+        double x = std::log10((double)allocated);
+        if (x >= xMax) bin = nBins+1;
+        else if (x >= xMin) bin = 1 + (int)((x-xMin)/(xMax-xMin)*nBins);
+    }
+    probe.counts[bin]++;
+}
+
+
+void AllocationProfiler::Write(TFileDirectory & dir) const
+{
+    std::map<std::string, TFileDirectory> groupDirs;
+
+    for (auto const & probe : mvProbes){
+        if (groupDirs.find(probe.group) == groupDirs.end()) groupDirs.insert(std::make_pair(probe.group, dir.mkdir(probe.group)));
+
+        // histogram names cannot hold spaces or slashes
+        std::string histName = probe.name;
+        for (auto & c : histName) if (c == ' ' || c == '/') c = '_';
+
+        std::string axis = mbJemalloc ? ";log_{10}(bytes allocated);calls" : ";log_{10}(net heap growth/bytes);calls";
+        TH1F * h = groupDirs.find(probe.group)->second.make<TH1F>(histName.c_str(), (probe.name+axis).c_str(), nBins, xMin, xMax);
+        for (int bin = 0; bin <= nBins+1; bin++) h->SetBinContent(bin, probe.counts[bin]);
+        h->SetEntries(probe.nCalls);
+    }
+}
+
+
+void AllocationProfiler::Print(std::ostream & out) const
+{
+    out << mLegend << "Heap per call (calls / " << (mbJemalloc ? "mean kB allocated / " : "") << "mean kB net / max kB retained per call):" << std::endl;
+    for (auto const & probe : mvProbes){
+        double n = probe.nCalls > 0 ? probe.nCalls : 1;
+        out << mLegend << "  " << std::left << std::setw(40) << (probe.group+"/"+probe.name) << std::right
+            << std::setw(12) << probe.nCalls << std::fixed << std::setprecision(1);
+        if (mbJemalloc) out << std::setw(12) << probe.bytesAllocated/n/1024.;
+        out << std::setw(12) << probe.netBytes/n/1024.
+            << std::setw(12) << probe.maxRetainedBytes/1024. << std::endl;
+    }
+    out.unsetf(std::ios::floatfield);
+    out.precision(6);
+    if (mbWrapped) out << mLegend << "WARNING: the heap passed 4 GB and the mallinfo counters wrapped, net changes above are modulo 2^32" << std::endl;
+}
@@ -0,0 +1,56 @@
+#include "FWLJMET/LJMet/interface/AngularMatcher.h"
+#include "DataFormats/Math/interface/deltaR.h"
+
+#include <algorithm>
+
+
+unsigned int AngularMatcher::Add(double eta, double phi)
+{
+    Target target = {eta, phi, (unsigned int)mvTargets.size()};
+    mvTargets.push_back(target);
+    mSorted = false;
+    return target.index;
+}
+
+
+void AngularMatcher::sort()
+{
+    if(mSorted) return;
+    std::stable_sort(mvTargets.begin(), mvTargets.end());
+    mSorted = true;
+}
+
+
+int AngularMatcher::Nearest(double eta, double phi, double dRMax, double & dR2)
+{
+    sort();
+
+    int best = -1;
+    dR2 = dRMax*dRMax;
+
+    Target low = {eta - dRMax, 0, 0};
+    for(auto it = std::lower_bound(mvTargets.begin(), mvTargets.end(), low); it != mvTargets.end() && it->eta < eta + dRMax; ++it){
+        double d2 = reco::deltaR2(eta, phi, it->eta, it->phi);
+        if(d2 < dR2 || (d2 == dR2 && best >= 0 && (int)it->index < best)){
+            dR2  = d2;
+            best = it->index;
+        }
+    }
+    return best;
+}
+
+
+void AngularMatcher::Within(double eta, double phi, double dRMax, std::vector<unsigned int> & out)
+{
+    sort();
+
+    out.clear();
+    double dRMax2 = dRMax*dRMax;
+
+    Target low = {eta - dRMax, 0, 0};
+    for(auto it = std::lower_bound(mvTargets.begin(), mvTargets.end(), low); it != mvTargets.end() && it->eta < eta + dRMax; ++it){
+        if(reco::deltaR2(eta, phi, it->eta, it->phi) < dRMax2) out.push_back(it->index);
+    }
+    std::sort(out.begin(), out.end());
+}
+
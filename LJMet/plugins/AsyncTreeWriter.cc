@@ -0,0 +1,132 @@
+#include "FWLJMET/LJMet/interface/AsyncTreeWriter.h"
+
+#include <exception>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+
+AsyncTreeWriter::AsyncTreeWriter(unsigned int depth, std::function<void()> fill):
+    mLegend("\t[AsyncTreeWriter]: "),
+    mFill(fill),
+    mbDone(false),
+    mnQueued(0),
+    mnWritten(0),
+    mnBlocked(0),
+    mBlockedTime(0)
+{
+    for (unsigned int i = 0; i < depth; ++i) mvFree.emplace_back(new Snapshot());
+
+    mThread = std::thread(&AsyncTreeWriter::run, this);
+}
+
+
+AsyncTreeWriter::~AsyncTreeWriter()
+{
+    if (!mThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mbDone = true;
+    }
+    mQueueCondition.notify_one();
+    mThread.join();
+}
+
+
+void AsyncTreeWriter::Push()
+{
+    std::unique_ptr<Snapshot> snapshot;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        rethrow();
+        if (mvFree.empty()) {
+            // back-pressure: depth events queued or being written
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            mFreeCondition.wait(lock, [this]{ return !mvFree.empty() || !mError.empty(); });
+            mBlockedTime += std::chrono::steady_clock::now() - start;
+            ++mnBlocked;
+            rethrow();
+        }
+        snapshot = std::move(mvFree.back());
+        mvFree.pop_back();
+    }
+
+    // the copy runs outside the lock, concurrently with the writer filling an earlier event
+    take(*snapshot, std::make_index_sequence<std::tuple_size<Snapshot>::value>());
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(std::move(snapshot));
+        ++mnQueued;
+    }
+    mQueueCondition.notify_one();
+}
+
+
+void AsyncTreeWriter::Finish()
+{
+    if (!mThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mbDone = true;
+    }
+    mQueueCondition.notify_one();
+    mThread.join();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    rethrow();
+}
+
+
+void AsyncTreeWriter::run()
+{
+    while (true) {
+        std::unique_ptr<Snapshot> snapshot;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mQueueCondition.wait(lock, [this]{ return !mQueue.empty() || mbDone; });
+            if (mQueue.empty()) return; // done and drained
+            snapshot = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        try {
+            give(*snapshot, std::make_index_sequence<std::tuple_size<Snapshot>::value>());
+            mFill();
+        }
+        catch (std::exception const & e) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mError = e.what();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mError = "unknown exception";
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mvFree.push_back(std::move(snapshot));
+            if (mError.empty()) ++mnWritten;
+            if (!mError.empty()) {
+                // drop what is still queued, Push and Finish report the error
+                mQueue.clear();
+                mFreeCondition.notify_one();
+                return;
+            }
+        }
+        mFreeCondition.notify_one();
+    }
+}
+
+
+void AsyncTreeWriter::rethrow()
+{
+    // mMutex held by the caller
+    if (!mError.empty()) throw cms::Exception("AsyncTreeWriter") << "TTree::Fill failed on the writer thread: " << mError << std::endl;
+}
+
+
+void AsyncTreeWriter::Print(std::ostream & out) const
+{
+    out << mLegend << mnQueued << " events queued, " << mnWritten << " written on the writer thread, event loop waited "
+        << mnBlocked << " times, " << std::chrono::duration<double>(mBlockedTime).count() << " s in total" << std::endl;
+}
@@ -159,6 +159,17 @@ bool BTagSFUtil::isJetTagged(const pat::Jet & jet,
                                         bool isMc,
                                         int shiftflag,
                                         bool subjetflag)
+{
+    return isJetTagged(jet, jet.phi(), correctedJet_lv, event, isMc, shiftflag, subjetflag);
+}
+
+bool BTagSFUtil::isJetTagged(const pat::Jet & jet,
+                                        double seedPhi,
+                                        TLorentzVector correctedJet_lv,
+                                        edm::Event const & event,
+                                        bool isMc,
+                                        int shiftflag,
+                                        bool subjetflag)
 {
     bool _isTagged = false;
 
@@ -215,7 +226,7 @@ bool BTagSFUtil::isJetTagged(const pat::Jet & jet,
       	_lightEff = mBtagCond.GetMistagRate(lvjet.Et(), fabs(lvjet.Eta()), "SJDeepCSV"+btagOP);
       }
 
-      SetSeed(abs(static_cast<int>(sin(jet.phi())*1e5)));
+      SetSeed(abs(static_cast<int>(sin(seedPhi)*1e5)));
 
       //modifyBTagsWithSF modifies _isTagged ! need to Check ! -- Mar 19, 2019
       modifyBTagsWithSF(_isTagged, _jetFlavor, _heavySf, _heavyEff, _lightSf, _lightEff);
@@ -7,9 +7,14 @@ mLegend("")
 {
 }
 
-void BaseCalc::SetHistogram(std::string name, int nbins, double low, double high)
+LjmetEventContent::HistHandle BaseCalc::SetHistogram(std::string name, int nbins, double low, double high)
 {
-    mpEc->SetHistogram(mName, name, nbins, low, high);
+    return mpEc->SetHistogram(mName, name, nbins, low, high);
+}
+
+LjmetEventContent::HistHandle BaseCalc::SetHistogram2D(std::string name, int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh)
+{
+    return mpEc->SetHistogram2D(mName, name, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh);
 }
 
 void BaseCalc::SetHistValue(std::string name, double value)
@@ -41,25 +46,25 @@ void BaseCalc::SetValue(std::string name, double value)
     mpEc->SetValue(_name, value);
 }
 
-void BaseCalc::SetValue(std::string name, std::vector<bool> value)
+void BaseCalc::SetValue(std::string name, std::vector<bool> const & value)
 {
     std::string _name = name + "_" + mName;
     mpEc->SetValue(_name, value);
 }
 
-void BaseCalc::SetValue(std::string name, std::vector<int> value)
+void BaseCalc::SetValue(std::string name, std::vector<int> const & value)
 {
     std::string _name = name + "_" + mName;
     mpEc->SetValue(_name, value);
 }
 
-void BaseCalc::SetValue(std::string name, std::vector<double> value)
+void BaseCalc::SetValue(std::string name, std::vector<double> const & value)
 {
     std::string _name = name + "_" + mName;
     mpEc->SetValue(_name, value);
 }
 
-void BaseCalc::SetValue(std::string name, std::vector<std::string> value)
+void BaseCalc::SetValue(std::string name, std::vector<std::string> const & value)
 {
   std::string _name = name + "_" + mName;
   mpEc->SetValue(_name, value);
@@ -8,10 +8,22 @@
 
 using namespace std;
 
+// names of BaseEventSelector::Collection, for printout
+static const char * collectionNames[] = {"SelCorrJets", "SelCorrJetsAK8", "CorrectedMet"};
+
 BaseEventSelector::BaseEventSelector():
+mpEvent(0),
+mpProfiler(0),
+mpAllocProfiler(0),
+mEventsCut(0),
 mName(""),
 mLegend("")
 {
+    for (int i = 0; i < nCollections; ++i){
+        mbDeclared[i] = false;
+        mbBuilt[i]    = false;
+        mbWarned[i]   = false;
+    }
 }
 
 
@@ -25,6 +37,30 @@ void BaseEventSelector::EndJob()
 
 void BaseEventSelector::BeginEvent(edm::EventBase const & event, LjmetEventContent & ec)
 {
+    mGenParticleIndex.Reset();
+    mLHESummary.Reset();
+    for (int i = 0; i < nCollections; ++i) mbBuilt[i] = false;
+}
+
+
+void BaseEventSelector::DeclareUse(Collection collection)
+{
+    if (!mbDeclared[collection]) std::cout << mLegend << "collection " << collectionNames[collection] << " will be built on demand" << std::endl;
+    mbDeclared[collection] = true;
+}
+
+
+void BaseEventSelector::require(Collection collection)
+{
+    if (mbBuilt[collection]) return;
+    mbBuilt[collection] = true;
+
+    if (!mbDeclared[collection] && !mbWarned[collection]){
+        std::cout << mLegend << "Warning: collection " << collectionNames[collection] << " read without being declared in BeginJob, building it anyway" << std::endl;
+        mbWarned[collection] = true;
+    }
+
+    if (mpEvent) BuildCollection(collection);
 }
 
 
@@ -36,7 +72,64 @@ void BaseEventSelector::EndEvent(edm::EventBase const & event, LjmetEventContent
 void BaseEventSelector::Init( void )
 {
 
-    mpEc->SetHistogram(mName, "nEvents", 4, -2,2); // to record total events prior to any selection (and ideally negative weights for MC). 
+    mEventsCut = RegisterCutStep("nEvents");
+    SetCutHistogram(mEventsCut, 4, -2,2); // to record total events prior to any selection (and ideally negative weights for MC). 
 
 }
 
+
+
+BaseEventSelector::CutHandle BaseEventSelector::RegisterCut(std::string const & name)
+{
+    push_back(name);
+
+    CutEntry entry;
+    entry.name      = name;
+    entry.index     = index_type(&bits_, name);
+    entry.flowIndex = cutFlow_.size() - 1; // push_back appends to the cut flow
+    entry.hist      = -1;
+    mvCuts.push_back(entry);
+
+    return mvCuts.size() - 1;
+}
+
+
+BaseEventSelector::CutHandle BaseEventSelector::RegisterCutStep(std::string const & name)
+{
+    CutEntry entry;
+    entry.name      = name;
+    entry.flowIndex = -1;
+    entry.hist      = -1;
+    mvCuts.push_back(entry);
+
+    return mvCuts.size() - 1;
+}
+
+
+void BaseEventSelector::SetCutHistogram(CutHandle cut, int nbins, double low, double high)
+{
+    CutEntry & entry = mvCuts[cut];
+    entry.hist = SetHistogram(entry.name, nbins, low, high);
+}
+
+
+void BaseEventSelector::PassCut(pat::strbitset & ret, CutHandle cut)
+{
+    CutEntry const & entry = mvCuts[cut];
+
+    if (entry.flowIndex >= 0){
+        ret[entry.index] = true;
+        ++cutFlow_[entry.flowIndex].second;
+    }
+
+    if (entry.hist >= 0) mpEc->FillHist(entry.hist, 1);
+}
+
+
+void BaseEventSelector::FillCutHist(CutHandle cut, double value)
+{
+    CutEntry const & entry = mvCuts[cut];
+
+    if (entry.hist >= 0) mpEc->FillHist(entry.hist, value);
+    else std::cout << mLegend << "Histogram of cut " << entry.name << " is not booked" << std::endl;
+}
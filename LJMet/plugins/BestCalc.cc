@@ -20,9 +20,10 @@ Requires MiniAOD inputs to access proper set of information
 #include <algorithm>
 #include <vector>
 
-#include "FWLJMET/LJMet/interface/BaseCalc.h"
+#include "FWLJMET/LJMet/interface/BestCalc.h"
 #include "FWLJMET/LJMet/interface/LjmetEventContent.h"
 #include "FWLJMET/LJMet/interface/LjmetFactory.h"
+#include "FWLJMET/LJMet/interface/AK8FeatureCache.h"
 #include "FWCore/ParameterSet/interface/ProcessDesc.h"
 #include "FWCore/PythonParameterSet/interface/PythonProcessDesc.h"
 //#include "FWLJMET/LJMet/interface/VVString.h"
@@ -61,91 +62,6 @@ Requires MiniAOD inputs to access proper set of information
 
 using namespace std;
 
-class LjmetFactory;
-
-class BestCalc : public BaseCalc {
-    //
-    // Best class for all calculators
-    //
-    //
-
-    
-public:
-    BestCalc();
-    virtual ~BestCalc() { }
-    virtual int BeginJob(edm::ConsumesCollector && iC);
-    virtual int ProduceEvent(edm::EventBase const & event, BaseEventSelector * selector) { return 0; }
-    virtual int AnalyzeEvent(edm::Event const & event, BaseEventSelector * selector);
-    virtual int EndJob();
-    
-    std::map<std::string,double> execute( const pat::Jet& jet );
-
-    void getJetValues( const pat::Jet& jet );
-
-    void pboost( TVector3 pbeam, TVector3 plab, TLorentzVector &pboo );
-
-    void FWMoments( std::vector<TLorentzVector> particles, double (&outputs)[5] );
-
-    float LegP(float x, int order);
-
-    unsigned int getParticleID();
-
-    void setConfigurations(const std::vector<std::string>& configurations);
-
-    void read_file( const std::string &file_name, std::vector<std::string> &values, const std::string &comment="#" );
-
-    bool str2bool( const std::string value );
-
-    std::string mName;
-    std::string mLegend;
-    
- private:
-    // lwtnn
-    lwt::LightweightNeuralNetwork* m_lwtnn;
-    std::map<std::string,double> m_BESTvars;
-    std::map<std::string,double> m_NNresults;
-
-    std::string m_dnnFile;
-
-    std::map<std::string,std::string> m_configurations; // map of configurations
-
-    // kinematics
-    float m_jetSoftDropMassMin; // [GeV] Jet soft drop mass minimum
-    float m_jetPtMin;           // [GeV] Jet pT minimum
-    unsigned int m_numSubjetsMin;    // minimum number of subjets
-    unsigned int m_numDaughtersMin;  // minimum number of daughters
-
-    // boosting to rest frames
-    float m_radiusSmall;        // re-clustering jets
-    float m_radiusLarge;        // re-clustering jets
-    float m_reclusterJetPtMin;  // [GeV] re-clustering jet pT minimum
-
-    float m_jetChargeKappa;     // weight for jet charge pT
-    size_t m_maxJetSize;        // number of jets in re-clustering
-
-    float m_Wmass = 80.4;       // W mass [GeV]
-    float m_Zmass = 91.2;       // Z mass
-    float m_Hmass = 125.;       // Higgs mass
-    float m_Tmass = 172.5;      // Top mass
-
-    std::map<std::string,std::string> m_defaultConfigs = {
-      {"dnnFile",             "BESTAnalysis/BoostedEventShapeTagger/data/BEST_mlp.json"},
-      {"radiusSmall",         "0.4"},
-      {"radiusLarge",         "0.8"},
-      {"reclusterJetPtMin",   "30.0"},
-      {"jetSoftDropMassMin",  "40.0"},
-      {"jetPtMin",            "500.0"},
-      {"jetChargeKappa",      "0.6"},
-      {"maxJetSize",          "4"},
-      {"numSubjetsMin",       "2"},
-      {"numDaughtersMin",     "2"} 
-    };
-    
-    lwt::JSONConfig cfg;
-    
-
-};
-
 
 static int reg = LjmetFactory::GetInstance()->Register(new BestCalc(), "BestCalc");
 
@@ -169,6 +85,8 @@ int BestCalc::BeginJob(edm::ConsumesCollector && iC){
     m_maxJetSize = mPset.getParameter<int>("maxJetSize");
     m_dnnFile = mPset.getParameter<edm::FileInPath>("dnnFile").fullPath();
 
+    DeclareUse(BaseEventSelector::kSelCorrJetsAK8);
+
     std::cout << "["+GetName()+"]: using json file: " << m_dnnFile << std::endl;     
     std::ifstream input_cfg( m_dnnFile );                     // original: "data/BEST_mlp.json"
     // lwt::JSONConfig cfg = lwt::parse_json( input_cfg );
@@ -190,6 +108,7 @@ int BestCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selecto
   //event.getByLabel(AK8JetColl, AK8Jets);
 
   std::vector<pat::Jet> const & vSelCorrJets_AK8 = selector->GetSelCorrJetsAK8();
+  AK8FeatureCache & ak8FeatureCache = selector->GetAK8Features();
 
   //Four std::vector
                                   
@@ -401,14 +320,14 @@ int BestCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selecto
     // for (unsigned int j = 0; j < labels.size(); j++){
     //   std::cout << labels.at(j) << std::endl;
     // }
-    auto const& thisSubjets   = ii->subjets("SoftDropPuppi");
+    AK8FeatureCache::JetFeatures const & ak8Features = ak8FeatureCache.Get(ii-vSelCorrJets_AK8.begin());
 
-    unsigned int numDaughters = ii->numberOfDaughters();
-    float softdropmass = ii->userFloat("ak8PFJetsPuppiSoftDropMass");
+    unsigned int numDaughters = ak8Features.nDaughters;
+    float softdropmass = ak8Features.softDropMassPuppi;
     int largest = 10;
 
-    if (thisSubjets.size() >= m_numSubjetsMin && numDaughters >= m_numDaughtersMin && softdropmass >= m_jetSoftDropMassMin){
-      varMap = BestCalc::execute(*ii);
+    if (ak8Features.subjets.size() >= m_numSubjetsMin && numDaughters >= m_numDaughtersMin && softdropmass >= m_jetSoftDropMassMin){
+      varMap = BestCalc::execute(*ii, ak8Features);
       myMap = m_lwtnn->compute(varMap);
 
       if (myMap["dnn_qcd"] > myMap["dnn_top"] && myMap["dnn_qcd"] > myMap["dnn_higgs"] && myMap["dnn_qcd"] > myMap["dnn_z"] && myMap["dnn_qcd"] > myMap["dnn_w"] && myMap["dnn_qcd"] > myMap["dnn_b"]){
@@ -631,9 +550,9 @@ int BestCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selecto
 }
 
 
-std::map<std::string,double> BestCalc::execute( const pat::Jet& jet ){
+std::map<std::string,double> BestCalc::execute( const pat::Jet& jet, AK8FeatureCache::JetFeatures const & features ){
   /* Dan Guest's lightweight DNN framework */
-  getJetValues(jet);                            // update m_BESTvars
+  getJetValues(jet, features);                          // update m_BESTvars
 
   // set values (testing)
   /*  m_NNresults = {
@@ -650,7 +569,7 @@ std::map<std::string,double> BestCalc::execute( const pat::Jet& jet ){
 }
 
 
-void BestCalc::getJetValues( const pat::Jet& jet ){
+void BestCalc::getJetValues( const pat::Jet& jet, AK8FeatureCache::JetFeatures const & features ){
   /* Grab attributes from the jet and store them in map
        Jet requirements:
          pT > 500 GeV
@@ -669,9 +588,9 @@ void BestCalc::getJetValues( const pat::Jet& jet ){
   // clear the map from the previous jet's values
   m_BESTvars.clear();
 
-  // Access the subjets
-  auto const& thisSubjets   = jet.subjets("SoftDropPuppi");
-  unsigned int numDaughters = jet.numberOfDaughters();
+  // Access the subjets (shared with the other calculators through the selector's AK8 feature cache)
+  auto const& thisSubjets   = features.subjets;
+  unsigned int numDaughters = features.nDaughters;
 
   // Do some checks on the jets and print warnings to the user
   if (thisSubjets.size() < m_numSubjetsMin){
@@ -686,19 +605,19 @@ void BestCalc::getJetValues( const pat::Jet& jet ){
     std::cout << " WARNING :: BEST : The jet pT " << jet.pt() << ", is less than " << m_jetPtMin << std::endl;
     std::cout << " WARNING :: BEST : -- BEST will run, but the results can't be trusted! Please check your jets! " << std::endl;
   }
-  if (jet.userFloat("ak8PFJetsPuppiSoftDropMass") < m_jetSoftDropMassMin){
-    std::cout << " WARNING :: BEST : The soft-drop mass " << jet.userFloat("ak8PFJetsPuppiSoftDropMass") << ", is less than " << m_jetSoftDropMassMin << std::endl;
+  if (features.softDropMassPuppi < m_jetSoftDropMassMin){
+    std::cout << " WARNING :: BEST : The soft-drop mass " << features.softDropMassPuppi << ", is less than " << m_jetSoftDropMassMin << std::endl;
     std::cout << " WARNING :: BEST : -- BEST will run, but the results can't be trusted! Please check your jets! " << std::endl;
   }
 
   // b-tagging
-  float btagValue1 = thisSubjets.at(0)->bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
-  float btagValue2 = thisSubjets.at(1)->bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
+  float btagValue1 = thisSubjets.at(0).csvv2;
+  float btagValue2 = thisSubjets.at(1).csvv2;
 
   // n-subjettiness
-  float tau1 = jet.userFloat("NjettinessAK8Puppi:tau1");
-  float tau2 = jet.userFloat("NjettinessAK8Puppi:tau2");
-  float tau3 = jet.userFloat("NjettinessAK8Puppi:tau3");
+  float tau1 = features.tau1;
+  float tau2 = features.tau2;
+  float tau3 = features.tau3;
 
   // BEST vars
   fourv thisJet = jet.polarP4();
@@ -1035,7 +954,7 @@ void BestCalc::getJetValues( const pat::Jet& jet ){
   m_BESTvars["et"]      = thisJet.Pt();
   m_BESTvars["eta"]     = thisJet.Rapidity();
   m_BESTvars["mass"]    = thisJet.M();
-  m_BESTvars["SDmass"]  = jet.userFloat("ak8PFJetsPuppiSoftDropMass");
+  m_BESTvars["SDmass"]  = features.softDropMassPuppi;
   m_BESTvars["tau32"]   = (tau2 > 1e-8) ? tau3/tau2 : 999.;
   m_BESTvars["tau21"]   = (tau1 > 1e-8) ? tau2/tau1 : 999.;
   m_BESTvars["q"]       = jetq;
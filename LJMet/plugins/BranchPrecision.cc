@@ -0,0 +1,97 @@
+#include "FWLJMET/LJMet/interface/BranchPrecision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fnmatch.h>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+
+static const char * modeNames[] = {"float", "mantissa", "fixed"};
+
+
+BranchPrecision::BranchPrecision():
+    mLegend("\t[BranchPrecision]: ")
+{
+}
+
+
+void BranchPrecision::Configure(std::vector<edm::ParameterSet> const & vRules)
+{
+    for (auto const & pset : vRules){
+        Rule rule;
+        rule.pattern  = pset.getUntrackedParameter<std::string>("pattern");
+        rule.bits     = pset.getUntrackedParameter<int>("bits", 0);
+        rule.min      = pset.getUntrackedParameter<double>("min", 0);
+        rule.max      = pset.getUntrackedParameter<double>("max", 0);
+        rule.nMatched = 0;
+
+        std::string mode = pset.getUntrackedParameter<std::string>("mode", "float");
+        if      (mode == "float")    rule.mode = kFloat;
+        else if (mode == "mantissa") rule.mode = kMantissa;
+        else if (mode == "fixed")    rule.mode = kFixed;
+        else throw cms::Exception("InvalidInput") << "Unknown precision mode: " << mode << std::endl;
+
+        if (rule.mode == kMantissa && (rule.bits < 1 || rule.bits > 23))
+            throw cms::Exception("InvalidInput") << "Mantissa bits out of range (1-23) for " << rule.pattern << ": " << rule.bits << std::endl;
+        if (rule.mode == kFixed && (rule.bits < 1 || rule.bits > 24 || !(rule.min < rule.max)))
+            throw cms::Exception("InvalidInput") << "Fixed point needs 1-24 bits and min < max for " << rule.pattern << std::endl;
+
+        mvRules.push_back(rule);
+    }
+}
+
+
+BranchPrecision::Rule const * BranchPrecision::Match(std::string const & name)
+{
+    for (auto & rule : mvRules){
+        if (fnmatch(rule.pattern.c_str(), name.c_str(), 0) != 0) continue;
+        rule.nMatched++;
+        return &rule;
+    }
+    return 0;
+}
+
+
+float BranchPrecision::Reduce(double value, Rule const & rule)
+{
+    if (rule.mode == kFixed){
+        if (std::isnan(value)) return value;
+        double x = std::min(std::max(value, rule.min), rule.max);
+        double steps = (double)((1u << rule.bits) - 1);
+        double q = std::round((x-rule.min)/(rule.max-rule.min)*steps);
+        return rule.min + q*(rule.max-rule.min)/steps;
+    }
+
+    float f = value;
+    if (rule.mode == kFloat || !std::isfinite(f)) return f;
+
+    // round to nearest on the kept mantissa bits; carries into the exponent are fine
+    int drop = 23 - rule.bits;
+    if (drop == 0) return f;
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    uint32_t rounded = (bits + (1u << (drop-1))) & ~((1u << drop) - 1);
+    float r;
+    std::memcpy(&r, &rounded, sizeof(r));
+    if (!std::isfinite(r)){
+        // rounded past the largest float, truncate instead
+        bits &= ~((1u << drop) - 1);
+        std::memcpy(&r, &bits, sizeof(r));
+    }
+    return r;
+}
+
+
+void BranchPrecision::Print(std::ostream & out) const
+{
+    for (auto const & rule : mvRules){
+        out << mLegend << rule.pattern << ": " << modeNames[rule.mode];
+        if (rule.mode == kMantissa) out << " " << rule.bits << " bits";
+        if (rule.mode == kFixed) out << " " << rule.bits << " bits on [" << rule.min << ", " << rule.max << "]";
+        out << ", " << rule.nMatched << " branches" << std::endl;
+    }
+}
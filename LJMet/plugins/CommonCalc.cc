@@ -50,6 +50,7 @@ int CommonCalc::BeginJob(edm::ConsumesCollector && iC){
     L1prefiringToken_up      = iC.consumes<double>(edm::InputTag("prefiringweight","NonPrefiringProbUp")); //Hardcoding.
     L1prefiringToken_down    = iC.consumes<double>(edm::InputTag("prefiringweight","NonPrefiringProbDown")); //Hardcoding.
 
+    DeclareUse(BaseEventSelector::kCorrectedMet);
 
   return 0;
 }
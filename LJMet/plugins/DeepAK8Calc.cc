@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 #include "FWLJMET/LJMet/interface/BaseCalc.h"
 #include "FWLJMET/LJMet/interface/LjmetEventContent.h"
@@ -44,6 +45,16 @@ class DeepAK8Calc : public BaseCalc {
 
  private:
 
+    /// Position of each decoder table entry in the jets' pairDiscri vector, -1 if absent
+    void resolveDiscriIndex(pat::Jet const & jet);
+    bool discriIndexValid(pat::Jet const & jet) const;
+
+    std::vector<int>   mvDiscriIndex;
+    unsigned int       mDiscriSize = 0;
+
+    // [jet x column] raw scores, columns are nominal J,T,H,Z,W,B,C then mass-decorrelated J,T,H,Z,W,B,C
+    std::vector<float> mvScores;
+
 };
 
 #endif
@@ -53,131 +64,149 @@ static int reg = LjmetFactory::GetInstance()->Register(new DeepAK8Calc(), "DeepA
 using namespace std;
 
 
+// J, T, H, Z, W, B, C = 0, 1, 2, 3, 4, 5, 6 (also the priority order for ties in the argmax)
+static const int  nDeepAK8Classes = 7;
+static const int  nDeepAK8Columns = 2*nDeepAK8Classes;
+static const char deepAK8ClassLetters[nDeepAK8Classes] = {'J','T','H','Z','W','B','C'};
+
+// discriminators summed into each column, in the order they are added up
+static const struct { const char * name; int column; } deepAK8Table[] = {
+  {"pfDeepBoostedJetTags:probQCDothers", 0},
+  {"pfDeepBoostedJetTags:probTbcq",      1},
+  {"pfDeepBoostedJetTags:probTbqq",      1},
+  {"pfDeepBoostedJetTags:probHbb",       2},
+  {"pfDeepBoostedJetTags:probHcc",       2},
+  {"pfDeepBoostedJetTags:probHqqqq",     2},
+  {"pfDeepBoostedJetTags:probZbb",       3},
+  {"pfDeepBoostedJetTags:probZcc",       3},
+  {"pfDeepBoostedJetTags:probZqq",       3},
+  {"pfDeepBoostedJetTags:probWcq",       4},
+  {"pfDeepBoostedJetTags:probWqq",       4},
+  {"pfDeepBoostedJetTags:probQCDbb",     5},
+  {"pfDeepBoostedJetTags:probQCDb",      5},
+  {"pfDeepBoostedJetTags:probQCDcc",     6},
+  {"pfDeepBoostedJetTags:probQCDc",      6},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probQCDothers", 7},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probTbcq",      8},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probTbqq",      8},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probHbb",       9},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probHcc",       9},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probHqqqq",     9},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probZbb",      10},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probZcc",      10},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probZqq",      10},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probWcq",      11},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probWqq",      11},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probQCDbb",    12},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probQCDb",     12},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probQCDcc",    13},
+  {"pfMassDecorrelatedDeepBoostedJetTags:probQCDc",     13},
+};
+static const int nDeepAK8Entries = sizeof(deepAK8Table)/sizeof(deepAK8Table[0]);
+
+
 int DeepAK8Calc::BeginJob(edm::ConsumesCollector && iC){
 
+  mvDiscriIndex.assign(nDeepAK8Entries, -1);
+
+  DeclareUse(BaseEventSelector::kSelCorrJetsAK8);
+
   return 0;
 
 }
 
 
+void DeepAK8Calc::resolveDiscriIndex(pat::Jet const & jet){
+
+  std::vector<std::pair<std::string, float> > const & discri = jet.getPairDiscri();
+
+  mDiscriSize = discri.size();
+  for (int e = 0; e < nDeepAK8Entries; e++){
+    mvDiscriIndex[e] = -1;
+    for (unsigned int d = 0; d < discri.size(); d++){
+      if (discri[d].first == deepAK8Table[e].name){ mvDiscriIndex[e] = d; break; }
+    }
+  }
+
+}
+
+
+bool DeepAK8Calc::discriIndexValid(pat::Jet const & jet) const {
+
+  std::vector<std::pair<std::string, float> > const & discri = jet.getPairDiscri();
+
+  if (discri.size() != mDiscriSize) return false;
+  for (int e = 0; e < nDeepAK8Entries; e++){
+    if (mvDiscriIndex[e] >= 0 && discri[mvDiscriIndex[e]].first != deepAK8Table[e].name) return false;
+  }
+  return true;
+
+}
+
+
 int DeepAK8Calc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selector){
-  //DECLARE VARIABLES
-  std::vector<double> dnn_B;
-  std::vector<double> dnn_C;
-  std::vector<double> dnn_J;
-  std::vector<double> dnn_W;
-  std::vector<double> dnn_Z;
-  std::vector<double> dnn_H;
-  std::vector<double> dnn_T;
-
-  std::vector<int> dnn_largest;
-  std::vector<int> decorr_largest;
-  
-  std::vector<double> decorr_B;
-  std::vector<double> decorr_C;
-  std::vector<double> decorr_J;
-  std::vector<double> decorr_W;
-  std::vector<double> decorr_Z;
-  std::vector<double> decorr_H;
-  std::vector<double> decorr_T;
 
   std::vector<pat::Jet> const & SelCorrAK8Jets = selector->GetSelCorrJetsAK8();
 
-  int i = 0; //i is an iterator
+  // Gather the raw scores of all jets into the [jet x column] matrix.
+  // The discriminator positions are searched once and reused while they hold: every jet is checked
+  // against the cached labels (one compare per entry), and the positions are searched again on a mismatch.
+  mvScores.assign(SelCorrAK8Jets.size()*nDeepAK8Columns, 0.0);
+
+  unsigned int nJets = 0;
   for (std::vector<pat::Jet>::const_iterator ijet = SelCorrAK8Jets.begin(); ijet != SelCorrAK8Jets.end(); ijet++){
 
-    if (ijet->pt() < 170) continue;    
- 
-    float rawL = ijet->bDiscriminator("pfDeepBoostedJetTags:probQCDothers");
-    float rawC = ijet->bDiscriminator("pfDeepBoostedJetTags:probQCDcc") + ijet->bDiscriminator("pfDeepBoostedJetTags:probQCDc");
-    float rawB = ijet->bDiscriminator("pfDeepBoostedJetTags:probQCDbb") + ijet->bDiscriminator("pfDeepBoostedJetTags:probQCDb");
-    float rawW = ijet->bDiscriminator("pfDeepBoostedJetTags:probWcq") + ijet->bDiscriminator("pfDeepBoostedJetTags:probWqq");
-    float rawZ = ijet->bDiscriminator("pfDeepBoostedJetTags:probZbb") + ijet->bDiscriminator("pfDeepBoostedJetTags:probZcc") + ijet->bDiscriminator("pfDeepBoostedJetTags:probZqq");
-    float rawH = ijet->bDiscriminator("pfDeepBoostedJetTags:probHbb") + ijet->bDiscriminator("pfDeepBoostedJetTags:probHcc") + ijet->bDiscriminator("pfDeepBoostedJetTags:probHqqqq");
-    float rawT = ijet->bDiscriminator("pfDeepBoostedJetTags:probTbcq") + ijet->bDiscriminator("pfDeepBoostedJetTags:probTbqq");
-
-    float rawmax = std::max({rawL,rawC,rawB,rawW,rawZ,rawH,rawT});    
-
-    int dnn_Largest = 10;
-    float epsilon = 1e-4;
-
-    // J, T, H, Z, W, B, C = 0, 1, 2, 3, 4, 5, 6
-    if (rawmax - rawL < epsilon) dnn_Largest = 0;
-    else if (rawmax - rawT < epsilon) dnn_Largest = 1;
-    else if (rawmax - rawH < epsilon) dnn_Largest = 2;
-    else if (rawmax - rawZ < epsilon) dnn_Largest = 3;
-    else if (rawmax - rawW < epsilon) dnn_Largest = 4;
-    else if (rawmax - rawB < epsilon) dnn_Largest = 5;
-    else if (rawmax - rawC < epsilon) dnn_Largest = 6;
-    else dnn_Largest = 10;
-
-
-    float dcrawL = ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probQCDothers");
-    float dcrawC = ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probQCDcc") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probQCDc");
-    float dcrawB = ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probQCDbb") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probQCDb");
-    float dcrawW = ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probWcq") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probWqq");
-    float dcrawZ = ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probZbb") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probZcc") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probZqq");
-    float dcrawH = ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probHbb") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probHcc") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probHqqqq");
-    float dcrawT = ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probTbcq") + ijet->bDiscriminator("pfMassDecorrelatedDeepBoostedJetTags:probTbqq");
-
-    float dcrawmax = std::max({dcrawL,dcrawC,dcrawB,dcrawW,dcrawZ,dcrawH,dcrawT});    
-
-    int decorr_Largest = 10;
-
-    // J, T, H, Z, W, B, C = 0, 1, 2, 3, 4, 5, 6
-    if (dcrawmax - dcrawL < epsilon) decorr_Largest = 0;
-    else if (dcrawmax - dcrawT < epsilon) decorr_Largest = 1;
-    else if (dcrawmax - dcrawH < epsilon) decorr_Largest = 2;
-    else if (dcrawmax - dcrawZ < epsilon) decorr_Largest = 3;
-    else if (dcrawmax - dcrawW < epsilon) decorr_Largest = 4;
-    else if (dcrawmax - dcrawB < epsilon) decorr_Largest = 5;
-    else if (dcrawmax - dcrawC < epsilon) decorr_Largest = 6;
-    else decorr_Largest = 10;
-
-
-    //PUSH_BACK(...)
-    dnn_B.push_back(rawB);
-    dnn_C.push_back(rawC);
-    dnn_J.push_back(rawL);
-    dnn_W.push_back(rawW);
-    dnn_Z.push_back(rawZ);
-    dnn_H.push_back(rawH);
-    dnn_T.push_back(rawT);
-
-    dnn_largest.push_back(dnn_Largest);
-    decorr_largest.push_back(decorr_Largest);
-
-    decorr_B.push_back(dcrawB);
-    decorr_C.push_back(dcrawC);
-    decorr_J.push_back(dcrawL);
-    decorr_W.push_back(dcrawW);
-    decorr_Z.push_back(dcrawZ);
-    decorr_H.push_back(dcrawH);
-    decorr_T.push_back(dcrawT);
-
-    i++;
+    if (ijet->pt() < 170) continue;
+
+    if (!discriIndexValid(*ijet)) resolveDiscriIndex(*ijet);
+
+    std::vector<std::pair<std::string, float> > const & discri = ijet->getPairDiscri();
+    float * row = &mvScores[nJets*nDeepAK8Columns];
+    for (int e = 0; e < nDeepAK8Entries; e++){
+      row[deepAK8Table[e].column] += (mvDiscriIndex[e] >= 0 ? discri[mvDiscriIndex[e]].second : -1000.f); // pat::Jet::bDiscriminator default
+    }
+
+    nJets++;
+  }
+
+  // Unpack columns and take the argmax per tagger
+  std::vector<double> dnn[nDeepAK8Classes];
+  std::vector<double> decorr[nDeepAK8Classes];
+  std::vector<int> dnn_largest(nJets);
+  std::vector<int> decorr_largest(nJets);
+
+  for (int c = 0; c < nDeepAK8Classes; c++){
+    dnn[c].resize(nJets);
+    decorr[c].resize(nJets);
+    for (unsigned int j = 0; j < nJets; j++){
+      dnn[c][j]    = mvScores[j*nDeepAK8Columns + c];
+      decorr[c][j] = mvScores[j*nDeepAK8Columns + nDeepAK8Classes + c];
+    }
+  }
+
+  float epsilon = 1e-4;
+  for (unsigned int j = 0; j < nJets; j++){
+    for (int tagger = 0; tagger < 2; tagger++){
+      float const * score = &mvScores[j*nDeepAK8Columns + tagger*nDeepAK8Classes];
+      float scoremax = *std::max_element(score, score + nDeepAK8Classes);
+
+      int largest = 10;
+      for (int c = 0; c < nDeepAK8Classes; c++){
+        if (scoremax - score[c] < epsilon){ largest = c; break; }
+      }
+      (tagger == 0 ? dnn_largest : decorr_largest)[j] = largest;
+    }
   }
 
   //SETVALUES...
-  SetValue("dnn_B",dnn_B);
-  SetValue("dnn_C",dnn_C);
-  SetValue("dnn_J",dnn_J);
-  SetValue("dnn_W",dnn_W);
-  SetValue("dnn_Z",dnn_Z);
-  SetValue("dnn_H",dnn_H);
-  SetValue("dnn_T",dnn_T);
+  for (int c = 0; c < nDeepAK8Classes; c++){
+    SetValue(std::string("dnn_")    + deepAK8ClassLetters[c], dnn[c]);
+    SetValue(std::string("decorr_") + deepAK8ClassLetters[c], decorr[c]);
+  }
 
   SetValue("dnn_largest",dnn_largest);
   SetValue("decorr_largest",decorr_largest);
 
-  SetValue("decorr_B",decorr_B);
-  SetValue("decorr_C",decorr_C);
-  SetValue("decorr_J",decorr_J);
-  SetValue("decorr_W",decorr_W);
-  SetValue("decorr_Z",decorr_Z);
-  SetValue("decorr_H",decorr_H);
-  SetValue("decorr_T",decorr_T);
-
   return 0;
 
 }
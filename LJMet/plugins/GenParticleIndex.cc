@@ -0,0 +1,66 @@
+#include "FWLJMET/LJMet/interface/GenParticleIndex.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+
+GenParticleIndex::GenParticleIndex():
+    mpParticles(0)
+{
+}
+
+
+void GenParticleIndex::Build(edm::Handle<reco::GenParticleCollection> const & genParticles)
+{
+    mpParticles = genParticles.product();
+    mProductId  = genParticles.id();
+
+    for(auto & bucket : mmByAbsPdgId) bucket.second.clear();
+    for(auto & bucket : mmByStatus)   bucket.second.clear();
+
+    unsigned int n = mpParticles->size();
+    for(unsigned int i = 0; i < n; i++){
+        reco::GenParticle const & p = (*mpParticles)[i];
+        mmByAbsPdgId[std::abs(p.pdgId())].push_back(i);
+        mmByStatus[p.status()].push_back(i);
+    }
+}
+
+
+std::vector<unsigned int> const & GenParticleIndex::WithAbsPdgId(int absPdgId) const
+{
+    auto found = mmByAbsPdgId.find(absPdgId);
+    return found == mmByAbsPdgId.end() ? mvEmpty : found->second;
+}
+
+
+std::vector<unsigned int> const & GenParticleIndex::WithStatus(int status) const
+{
+    auto found = mmByStatus.find(status);
+    return found == mmByStatus.end() ? mvEmpty : found->second;
+}
+
+
+void GenParticleIndex::merge(std::vector<std::vector<unsigned int> const *> const & buckets, std::vector<unsigned int> & out) const
+{
+    out.clear();
+    for(auto bucket : buckets) out.insert(out.end(), bucket->begin(), bucket->end());
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+
+void GenParticleIndex::SelectAbsPdgIds(std::vector<int> const & absPdgIds, std::vector<unsigned int> & out) const
+{
+    std::vector<std::vector<unsigned int> const *> buckets;
+    for(int id : absPdgIds) buckets.push_back(&WithAbsPdgId(id));
+    merge(buckets, out);
+}
+
+
+void GenParticleIndex::SelectStatuses(std::vector<int> const & statuses, std::vector<unsigned int> & out) const
+{
+    std::vector<std::vector<unsigned int> const *> buckets;
+    for(int status : statuses) buckets.push_back(&WithStatus(status));
+    merge(buckets, out);
+}
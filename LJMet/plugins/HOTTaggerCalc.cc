@@ -70,6 +70,27 @@ public:
   
 private:
 
+  // Per-jet tagger inputs, staged into fixed slots. The extra-variable names are bound to the
+  // slots once in BeginJob so no key strings are built per jet.
+  enum ExtraVarSlot {
+    kQgMult, kQgPtD, kQgAxis1, kQgAxis2,
+    kChargedHadronEnergyFraction, kChargedEmEnergyFraction, kNeutralEmEnergyFraction, kMuonEnergyFraction,
+    kHFHadronEnergyFraction, kHFEMEnergyFraction, kNeutralHadronEnergyFraction, kPhotonEnergyFraction, kElectronEnergyFraction,
+    kChargedHadronMultiplicity, kNeutralHadronMultiplicity, kPhotonMultiplicity, kElectronMultiplicity, kMuonMultiplicity,
+    kDeepCSVb, kDeepCSVc, kDeepCSVl, kDeepCSVbb, kDeepCSVcc,
+    nExtraVarSlots
+  };
+
+  void stageJet(const pat::Jet & jet, double (&vars)[nExtraVarSlots]) const;
+
+  std::vector<std::string> extraVarNames_;
+  std::string deepCSVbKey_;
+  std::string deepCSVcKey_;
+  std::string deepCSVlKey_;
+  std::string deepCSVbbKey_;
+  std::string deepCSVccKey_;
+  size_t constituentCapacity_ = 0; // largest input seen so far, runTagger takes ownership of the vector every event
+
   double ak4ptCut_;
   std::string qgTaggerKey_;
   std::string deepCSVBJetTags_;
@@ -93,7 +114,41 @@ int HOTTaggerCalc::BeginJob(edm::ConsumesCollector && iC){
     bTagKeyString_ = mPset.getParameter<std::string>("bTagKeyString");    
     taggerCfgFile_ = mPset.getParameter<edm::FileInPath>("taggerCfgFile").fullPath();
     discriminatorCut_ = mPset.getParameter<double>("discriminatorCut");
+
+    deepCSVbKey_  = deepCSVBJetTags_+":probb";
+    deepCSVcKey_  = deepCSVBJetTags_+":probc";
+    deepCSVlKey_  = deepCSVBJetTags_+":probudsg";
+    deepCSVbbKey_ = deepCSVBJetTags_+":probbb";
+    deepCSVccKey_ = deepCSVBJetTags_+":probcc";
+
+    //bind the tagger extra-variable names to their slots
+    extraVarNames_.assign(nExtraVarSlots, "");
+    extraVarNames_[kQgMult]                      = "qgMult";
+    extraVarNames_[kQgPtD]                       = "qgPtD";
+    extraVarNames_[kQgAxis1]                     = "qgAxis1";
+    extraVarNames_[kQgAxis2]                     = "qgAxis2";
+    extraVarNames_[kChargedHadronEnergyFraction] = "recoJetschargedHadronEnergyFraction";
+    extraVarNames_[kChargedEmEnergyFraction]     = "recoJetschargedEmEnergyFraction";
+    extraVarNames_[kNeutralEmEnergyFraction]     = "recoJetsneutralEmEnergyFraction";
+    extraVarNames_[kMuonEnergyFraction]          = "recoJetsmuonEnergyFraction";
+    extraVarNames_[kHFHadronEnergyFraction]      = "recoJetsHFHadronEnergyFraction";
+    extraVarNames_[kHFEMEnergyFraction]          = "recoJetsHFEMEnergyFraction";
+    extraVarNames_[kNeutralHadronEnergyFraction] = "recoJetsneutralEnergyFraction";
+    extraVarNames_[kPhotonEnergyFraction]        = "PhotonEnergyFraction";
+    extraVarNames_[kElectronEnergyFraction]      = "ElectronEnergyFraction";
+    extraVarNames_[kChargedHadronMultiplicity]   = "ChargedHadronMultiplicity";
+    extraVarNames_[kNeutralHadronMultiplicity]   = "NeutralHadronMultiplicity";
+    extraVarNames_[kPhotonMultiplicity]          = "PhotonMultiplicity";
+    extraVarNames_[kElectronMultiplicity]        = "ElectronMultiplicity";
+    extraVarNames_[kMuonMultiplicity]            = "MuonMultiplicity";
+    extraVarNames_[kDeepCSVb]                    = "DeepCSVb";
+    extraVarNames_[kDeepCSVc]                    = "DeepCSVc";
+    extraVarNames_[kDeepCSVl]                    = "DeepCSVl";
+    extraVarNames_[kDeepCSVbb]                   = "DeepCSVbb";
+    extraVarNames_[kDeepCSVcc]                   = "DeepCSVcc";
     
+    DeclareUse(BaseEventSelector::kSelCorrJets);
+
     //configure the top tagger
     try{
 		//For working directory use cfg file location
@@ -119,70 +174,30 @@ int HOTTaggerCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * se
 
   //container holding input jet info for top tagger
   std::vector<Constituent> constituents;
-  
+  constituents.reserve(std::max(constituentCapacity_, vSelCorrJets.size()));
+
+  double vars[nExtraVarSlots];
+
   int nAK4 = 0; // to check against the number of jets from singleLepCalc, they should be the same
   for (std::vector<pat::Jet>::const_iterator ijet = vSelCorrJets.begin(); ijet != vSelCorrJets.end(); ijet++){
     int iJet = (int)(ijet-vSelCorrJets.begin());
-      
-    const pat::Jet jet = *ijet;
-      
+
+    const pat::Jet & jet = *ijet;
+
     //Apply pt cut on jets -- this should do nothing if the cut is left at 20
     if(jet.pt() < ak4ptCut_) continue;
     nAK4++;
 
     TLorentzVector perJetLVec(jet.p4().X(), jet.p4().Y(), jet.p4().Z(), jet.p4().T());
-      
-    double qgPtD = jet.userFloat("QGTagger:ptD");
-    double qgAxis1 = jet.userFloat("QGTagger:axis1");
-    double qgAxis2 = jet.userFloat("QGTagger:axis2");
-    double qgMult = static_cast<double>(jet.userInt("QGTagger:mult"));
-    double deepCSVb = jet.bDiscriminator((deepCSVBJetTags_+":probb").c_str());
-    double deepCSVc = jet.bDiscriminator((deepCSVBJetTags_+":probc").c_str());
-    double deepCSVl = jet.bDiscriminator((deepCSVBJetTags_+":probudsg").c_str());
-    double deepCSVbb = jet.bDiscriminator((deepCSVBJetTags_+":probbb").c_str());
-    double deepCSVcc = jet.bDiscriminator((deepCSVBJetTags_+":probcc").c_str());
-    double btag = jet.bDiscriminator(bTagKeyString_.c_str());
-    double chargedHadronEnergyFraction = jet.chargedHadronEnergyFraction();
-    double neutralHadronEnergyFraction = jet.neutralHadronEnergyFraction();
-    double chargedEmEnergyFraction = jet.chargedEmEnergyFraction();
-    double neutralEmEnergyFraction = jet.neutralEmEnergyFraction();
-    double muonEnergyFraction = jet.muonEnergyFraction();
-    double photonEnergyFraction = jet.photonEnergyFraction();
-    double electronEnergyFraction = jet.electronEnergyFraction();
-    double recoJetsHFHadronEnergyFraction = jet.HFHadronEnergyFraction();
-    double recoJetsHFEMEnergyFraction = jet.HFEMEnergyFraction();
-    double chargedHadronMultiplicity = jet.chargedHadronMultiplicity();
-    double neutralHadronMultiplicity = jet.neutralHadronMultiplicity();
-    double photonMultiplicity = jet.photonMultiplicity();
-    double electronMultiplicity = jet.electronMultiplicity();
-    double muonMultiplicity = jet.muonMultiplicity();
-    
+    double btag = jet.bDiscriminator(bTagKeyString_);
+
+    stageJet(jet, vars);
+
     constituents.emplace_back(perJetLVec, btag, 0.0);
     constituents.back().setIndex(iJet);
-    constituents.back().setExtraVar("qgMult"                              , qgMult);
-    constituents.back().setExtraVar("qgPtD"                               , qgPtD);
-    constituents.back().setExtraVar("qgAxis1"                             , qgAxis1);
-    constituents.back().setExtraVar("qgAxis2"                             , qgAxis2);
-    constituents.back().setExtraVar("recoJetschargedHadronEnergyFraction" , chargedHadronEnergyFraction);
-    constituents.back().setExtraVar("recoJetschargedEmEnergyFraction"     , chargedEmEnergyFraction);
-    constituents.back().setExtraVar("recoJetsneutralEmEnergyFraction"     , neutralEmEnergyFraction);
-    constituents.back().setExtraVar("recoJetsmuonEnergyFraction"          , muonEnergyFraction);
-    constituents.back().setExtraVar("recoJetsHFHadronEnergyFraction"      , recoJetsHFHadronEnergyFraction);
-    constituents.back().setExtraVar("recoJetsHFEMEnergyFraction"          , recoJetsHFEMEnergyFraction);
-    constituents.back().setExtraVar("recoJetsneutralEnergyFraction"       , neutralHadronEnergyFraction);
-    constituents.back().setExtraVar("PhotonEnergyFraction"                , photonEnergyFraction);
-    constituents.back().setExtraVar("ElectronEnergyFraction"              , electronEnergyFraction);
-    constituents.back().setExtraVar("ChargedHadronMultiplicity"           , chargedHadronMultiplicity);
-    constituents.back().setExtraVar("NeutralHadronMultiplicity"           , neutralHadronMultiplicity);
-    constituents.back().setExtraVar("PhotonMultiplicity"                  , photonMultiplicity);
-    constituents.back().setExtraVar("ElectronMultiplicity"                , electronMultiplicity);
-    constituents.back().setExtraVar("MuonMultiplicity"                    , muonMultiplicity);
-    constituents.back().setExtraVar("DeepCSVb"                            , deepCSVb);
-    constituents.back().setExtraVar("DeepCSVc"                            , deepCSVc);
-    constituents.back().setExtraVar("DeepCSVl"                            , deepCSVl);
-    constituents.back().setExtraVar("DeepCSVbb"                           , deepCSVbb);
-    constituents.back().setExtraVar("DeepCSVcc"                           , deepCSVcc);
+    for (int slot = 0; slot < nExtraVarSlots; slot++) constituents.back().setExtraVar(extraVarNames_[slot], vars[slot]);
   }
+  constituentCapacity_ = std::max(constituentCapacity_, constituents.size());
   
   //run top tagger
   try{
@@ -276,3 +291,30 @@ int HOTTaggerCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * se
   return 0;
 }
 
+
+void HOTTaggerCalc::stageJet(const pat::Jet & jet, double (&vars)[nExtraVarSlots]) const
+{
+  vars[kQgMult]                      = static_cast<double>(jet.userInt("QGTagger:mult"));
+  vars[kQgPtD]                       = jet.userFloat("QGTagger:ptD");
+  vars[kQgAxis1]                     = jet.userFloat("QGTagger:axis1");
+  vars[kQgAxis2]                     = jet.userFloat("QGTagger:axis2");
+  vars[kChargedHadronEnergyFraction] = jet.chargedHadronEnergyFraction();
+  vars[kChargedEmEnergyFraction]     = jet.chargedEmEnergyFraction();
+  vars[kNeutralEmEnergyFraction]     = jet.neutralEmEnergyFraction();
+  vars[kMuonEnergyFraction]          = jet.muonEnergyFraction();
+  vars[kHFHadronEnergyFraction]      = jet.HFHadronEnergyFraction();
+  vars[kHFEMEnergyFraction]          = jet.HFEMEnergyFraction();
+  vars[kNeutralHadronEnergyFraction] = jet.neutralHadronEnergyFraction();
+  vars[kPhotonEnergyFraction]        = jet.photonEnergyFraction();
+  vars[kElectronEnergyFraction]      = jet.electronEnergyFraction();
+  vars[kChargedHadronMultiplicity]   = jet.chargedHadronMultiplicity();
+  vars[kNeutralHadronMultiplicity]   = jet.neutralHadronMultiplicity();
+  vars[kPhotonMultiplicity]          = jet.photonMultiplicity();
+  vars[kElectronMultiplicity]        = jet.electronMultiplicity();
+  vars[kMuonMultiplicity]            = jet.muonMultiplicity();
+  vars[kDeepCSVb]                    = jet.bDiscriminator(deepCSVbKey_);
+  vars[kDeepCSVc]                    = jet.bDiscriminator(deepCSVcKey_);
+  vars[kDeepCSVl]                    = jet.bDiscriminator(deepCSVlKey_);
+  vars[kDeepCSVbb]                   = jet.bDiscriminator(deepCSVbbKey_);
+  vars[kDeepCSVcc]                   = jet.bDiscriminator(deepCSVccKey_);
+}
@@ -0,0 +1,115 @@
+#include "FWLJMET/LJMet/interface/HistAccumulator.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+
+const unsigned int HistAccumulator::nMaxSlots;
+
+
+HistAccumulator::Slot::Slot(unsigned int nDoubles, bool isShared):
+    storage((nDoubles+7)/8*8 + 8),
+    data(0),
+    shared(isShared)
+{
+    // whole 64-byte lines, the allocator only guarantees the alignment of a double
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage.data());
+    data = reinterpret_cast<double *>((address + 63) & ~std::uintptr_t(63));
+}
+
+
+HistAccumulator::HistAccumulator():
+    mnDoubles(0),
+    mbSlotCreated(false)
+{
+}
+
+
+int HistAccumulator::Book(int nbinsx, double xmin, double xmax, int nbinsy, double ymin, double ymax)
+{
+    if (mbSlotCreated) throw cms::Exception("LogicError") << "HistAccumulator: histogram booked after the first fill" << std::endl;
+
+    Layout layout;
+    layout.x.nbins = nbinsx;
+    layout.x.min   = xmin;
+    layout.x.max   = xmax;
+    layout.y.nbins = nbinsy;
+    layout.y.min   = ymin;
+    layout.y.max   = ymax;
+    layout.nBins   = (nbinsx+2)*(nbinsy > 0 ? nbinsy+2 : 1);
+    layout.offset  = mnDoubles;
+
+    mnDoubles += 1 + 2*layout.nBins;
+    mvLayout.push_back(layout);
+
+    return mvLayout.size()-1;
+}
+
+
+HistAccumulator::Slot & HistAccumulator::slotOfThread()
+{
+    static std::atomic<unsigned int> nextThread(0);
+    thread_local unsigned int thread = nextThread++;
+
+    if (thread < nMaxSlots){
+        // only this thread ever touches its slot
+        if (!mSlots[thread]){
+            mSlots[thread].reset(new Slot(mnDoubles, false));
+            mbSlotCreated = true;
+        }
+        return *mSlots[thread];
+    }
+
+    std::lock_guard<std::mutex> lock(mSlotMutex);
+    if (!mSharedSlot){
+        mSharedSlot.reset(new Slot(mnDoubles, true));
+        mbSlotCreated = true;
+    }
+    return *mSharedSlot;
+}
+
+
+void HistAccumulator::Merge(int hist, TH1 * h)
+{
+    Layout const & layout = mvLayout[hist];
+
+    double entries = 0;
+    std::vector<double> sumw(layout.nBins, 0);
+    std::vector<double> sumw2(layout.nBins, 0);
+
+    auto collect = [&](Slot * slot){
+        if (!slot) return;
+        double * block = slot->data + layout.offset;
+        entries += block[0];
+        block[0] = 0;
+        for (unsigned int bin = 0; bin < layout.nBins; bin++){
+            sumw[bin]  += block[1+2*bin];
+            sumw2[bin] += block[2+2*bin];
+            block[1+2*bin] = 0;
+            block[2+2*bin] = 0;
+        }
+    };
+    for (unsigned int i = 0; i < nMaxSlots; i++) collect(mSlots[i].get());
+    collect(mSharedSlot.get());
+
+    if (entries == 0) return;
+
+    // as TH1::Fill, the sum of squares is only kept once a weight is not 1
+    bool weighted = h->GetSumw2N() > 0;
+    for (unsigned int bin = 0; bin < layout.nBins && !weighted; bin++) weighted = sumw2[bin] != sumw[bin];
+    if (weighted && h->GetSumw2N() == 0) h->Sumw2();
+
+    entries += h->GetEntries();
+    for (unsigned int bin = 0; bin < layout.nBins; bin++){
+        if (sumw2[bin] == 0) continue;
+        double error = h->GetBinError(bin);
+        h->SetBinContent(bin, h->GetBinContent(bin) + sumw[bin]);
+        if (weighted) h->SetBinError(bin, std::sqrt(error*error + sumw2[bin]));
+    }
+
+    // mean and RMS from the bin centres, the unbinned sums are not kept
+    h->ResetStats();
+    h->SetEntries(entries);
+}
@@ -0,0 +1,136 @@
+#include "FWLJMET/LJMet/interface/JetCorrectionGuard.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+const unsigned int JetCorrectionGuard::nMaxPrint;
+
+static const char * kindNames[JetCorrectionGuard::nKinds]     = {"JES", "JEC uncertainty"};
+static const char * statusNames[JetCorrectionGuard::nStatus]  = {"ok", "bad input (pt <= 0 or not finite)", "eta outside the correction range", "exception"};
+
+
+JetCorrectionGuard::Domain JetCorrectionGuard::MakeDomain(JetCorrectorParameters const & par)
+{
+    Domain domain;
+
+    // only parameters binned in eta restrict the domain
+    JetCorrectorParameters::Definitions const & definitions = par.definitions();
+    if (definitions.nBinVar() == 0 || definitions.binVar(0) != "JetEta" || par.size() == 0) return domain;
+
+    domain.etaMin = par.record(0).xMin(0);
+    domain.etaMax = par.record(0).xMax(0);
+    for (unsigned int i = 1; i < par.size(); i++){
+        domain.etaMin = std::min(domain.etaMin, par.record(i).xMin(0));
+        domain.etaMax = std::max(domain.etaMax, par.record(i).xMax(0));
+    }
+
+    return domain;
+}
+
+
+JetCorrectionGuard::Domain JetCorrectionGuard::MakeDomain(std::vector<JetCorrectorParameters> const & vPar)
+{
+    Domain domain;
+    for (auto const & par : vPar){
+        Domain level = MakeDomain(par);
+        domain.etaMin = std::max(domain.etaMin, level.etaMin);
+        domain.etaMax = std::min(domain.etaMax, level.etaMax);
+    }
+    return domain;
+}
+
+
+JetCorrectionGuard::JetCorrectionGuard():
+    mLegend("\t[JetCorrectionGuard]: ")
+{
+    for (int kind = 0; kind < nKinds; kind++){
+        for (int status = 0; status < nStatus; status++) mCounts[kind][status] = 0;
+    }
+}
+
+
+JetCorrectionGuard::Status JetCorrectionGuard::check(Domain const & domain, double eta, double pt) const
+{
+    if (!std::isfinite(eta) || !std::isfinite(pt) || pt <= 0) return kBadInput;
+    if (eta < domain.etaMin || eta >= domain.etaMax) return kEtaOutOfRange;
+    return kOk;
+}
+
+
+void JetCorrectionGuard::count(Kind kind, Status status, double eta, double pt)
+{
+    unsigned long long n = ++mCounts[kind][status];
+    if (status == kOk || n > nMaxPrint) return;
+
+    std::cout << mLegend << "WARNING! " << kindNames[kind] << " not evaluated, " << statusNames[status]
+              << " (eta " << eta << ", pt " << pt << "). Jet/MET will remain uncorrected." << std::endl;
+    if (n == nMaxPrint) std::cout << mLegend << "WARNING! Further cases are only counted, see the summary at the end of the job." << std::endl;
+}
+
+
+JetCorrectionGuard::Status JetCorrectionGuard::SubCorrections(FactorizedJetCorrector & corrector, Domain const & domain,
+                                                              double eta, double pt, double area, double rho,
+                                                              std::vector<float> & corrVec)
+{
+    Status status = check(domain, eta, pt);
+
+    if (status == kOk){
+        corrector.setJetEta(eta);
+        corrector.setJetPt(pt);
+        corrector.setJetA(area);
+        corrector.setRho(rho);
+
+        // left as a last resort: nothing should throw once the domain is checked
+        try{
+            corrVec = corrector.getSubCorrections();
+        }
+        catch(...){
+            status = kException;
+        }
+    }
+
+    if (status != kOk) corrVec.assign(1, 1.0);
+
+    count(kJES, status, eta, pt);
+    return status;
+}
+
+
+JetCorrectionGuard::Status JetCorrectionGuard::Uncertainty(JetCorrectionUncertainty & jecUnc, Domain const & domain,
+                                                           double eta, double pt, bool up, double & unc)
+{
+    Status status = check(domain, eta, pt);
+
+    unc = 0.0;
+    if (status == kOk){
+        jecUnc.setJetEta(eta);
+        jecUnc.setJetPt(pt);
+
+        try{
+            unc = jecUnc.getUncertainty(up);
+        }
+        catch(...){
+            status = kException;
+            unc = 0.0;
+        }
+    }
+
+    count(kUncertainty, status, eta, pt);
+    return status;
+}
+
+
+void JetCorrectionGuard::Print(std::ostream & out) const
+{
+    for (int kind = 0; kind < nKinds; kind++){
+        unsigned long long total = 0;
+        for (int status = 0; status < nStatus; status++) total += mCounts[kind][status];
+
+        for (int status = kOk+1; status < nStatus; status++){
+            if (mCounts[kind][status] == 0) continue;
+            out << mLegend << kindNames[kind] << ": " << mCounts[kind][status] << " of " << total
+                << " evaluations skipped, " << statusNames[status] << std::endl;
+        }
+    }
+}
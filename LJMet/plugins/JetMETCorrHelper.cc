@@ -2,6 +2,9 @@
 
 #include "FWLJMET/LJMet/interface/JetMETCorrHelper.h"
 
+#include <algorithm>
+#include <limits>
+
 using namespace std;
 
 JetMETCorrHelper::JetMETCorrHelper()
@@ -48,7 +51,14 @@ void JetMETCorrHelper::Initialize(const edm::ParameterSet& iConfig){
     mJetParStr["DataL3JetParAK8"] = iConfig.getParameter<edm::FileInPath>("DataL3JetParAK8").fullPath();
     mJetParStr["DataResJetParAK8"] = iConfig.getParameter<edm::FileInPath>("DataResJetParAK8").fullPath();
 
-    if ( isMc ) jecUnc = std::shared_ptr<JetCorrectionUncertainty>( new JetCorrectionUncertainty(JEC_txtfile) );
+    mConfigKey = std::string(isMc ? "mc" : "data") + ";" + JEC_txtfile + ";" + JERSF_txtfile + ";" + JER_txtfile + ";" + JERAK8_txtfile;
+    for (auto const & par : mJetParStr) mConfigKey += ";" + par.second;
+
+    mGuard.SetLegend(mLegend);
+    if ( isMc ) {
+      jecUnc = std::shared_ptr<JetCorrectionUncertainty>( new JetCorrectionUncertainty(JEC_txtfile) );
+      mJecUncDomain = JetCorrectionGuard::MakeDomain(JetCorrectorParameters(JEC_txtfile));
+    }
 
     resolution = JME::JetResolution(JER_txtfile);
     resolutionAK8 = JME::JetResolution(JERAK8_txtfile);
@@ -76,73 +86,83 @@ void JetMETCorrHelper::Initialize(const edm::ParameterSet& iConfig){
 
       JetCorrector = std::shared_ptr<FactorizedJetCorrector>(new FactorizedJetCorrector(vPar) );
       JetCorrectorAK8 = std::shared_ptr<FactorizedJetCorrector>(new FactorizedJetCorrector(vParAK8) );
+      mJetCorrectorDomain = JetCorrectionGuard::MakeDomain(vPar);
+      mJetCorrectorAK8Domain = JetCorrectionGuard::MakeDomain(vParAK8);
 
     }
     else if ( !isMc ) {
-      // Create the JetCorrectorParameter objects, the order does not matter.
 
-      mEraReplaceStr["B"] = "B_V";
-      mEraReplaceStr["C"] = "C_V";
-      mEraReplaceStr["DE"] = "DE_V";
-      mEraReplaceStr["F"] = "F_V";
-
-      for (std::map<std::string,std::string>::iterator it=mEraReplaceStr.begin();it!=mEraReplaceStr.end();it++){
-
-          std::string era = it->first;
-          std::string replaceStr = it->second;
-
-          //Fetch the text files
-          mEraJetParStr[era]["DataL1JetParByIOV"]  = std::regex_replace(mJetParStr["DataL1JetPar"],std::regex("B_V"), replaceStr);
-          mEraJetParStr[era]["DataL2JetParByIOV"]  = std::regex_replace(mJetParStr["DataL2JetPar"],std::regex("B_V"), replaceStr);
-          mEraJetParStr[era]["DataL3JetParByIOV"]  = std::regex_replace(mJetParStr["DataL3JetPar"],std::regex("B_V"), replaceStr);
-          mEraJetParStr[era]["DataResJetParByIOV"]  = std::regex_replace(mJetParStr["DataResJetPar"],std::regex("B_V"), replaceStr);
-
-          mEraJetParStr[era]["DataL1JetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataL1JetParAK8"],std::regex("B_V"), replaceStr);
-          mEraJetParStr[era]["DataL2JetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataL2JetParAK8"],std::regex("B_V"), replaceStr);
-          mEraJetParStr[era]["DataL3JetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataL3JetParAK8"],std::regex("B_V"), replaceStr);
-          mEraJetParStr[era]["DataResJetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataResJetParAK8"],std::regex("B_V"), replaceStr);
-
-          if(debug) std::cout << mLegend << "Using JEC files DataL1JetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL1JetParByIOV"] << std::endl;
-          if(debug) std::cout << mLegend << "Using JEC files DataL2JetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL2JetParByIOV"] << std::endl;
-          if(debug) std::cout << mLegend << "Using JEC files DataL3JetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL3JetParByIOV"] << std::endl;
-          if(debug) std::cout << mLegend << "Using JEC files DataResJetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataResJetParByIOV"] << std::endl;
-
-          if(debug) std::cout << mLegend << "Using JEC files DataL1JetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL1JetParAK8ByIOV"] << std::endl;
-          if(debug) std::cout << mLegend << "Using JEC files DataL2JetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL2JetParAK8ByIOV"] << std::endl;
-          if(debug) std::cout << mLegend << "Using JEC files DataL3JetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL3JetParAK8ByIOV"] << std::endl;
-          if(debug) std::cout << mLegend << "Using JEC files DataResJetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataResJetParAK8ByIOV"] << std::endl;
-
-
-          mEra_mStrJetCorPar[era]["ResJetPar"] = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataResJetParByIOV"]) );
-          mEra_mStrJetCorPar[era]["L3JetPar"]  = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataL3JetParByIOV"]) );
-          mEra_mStrJetCorPar[era]["L2JetPar"]  = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataL2JetParByIOV"]) );
-          mEra_mStrJetCorPar[era]["L1JetPar"]  = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataL1JetParByIOV"]) );
-          mEra_mStrJetCorPar[era]["ResJetParAK8"] = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataResJetParAK8ByIOV"]) );
-          mEra_mStrJetCorPar[era]["L3JetParAK8"]  = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataL3JetParAK8ByIOV"]) );
-          mEra_mStrJetCorPar[era]["L2JetParAK8"]  = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataL2JetParAK8ByIOV"]) );
-          mEra_mStrJetCorPar[era]["L1JetParAK8"]  = std::shared_ptr<JetCorrectorParameters>( new JetCorrectorParameters(mEraJetParStr[era]["DataL1JetParAK8ByIOV"]) );
-
-          // Load the JetCorrectorParameter objects into a std::vector,
-          // IMPORTANT: THE ORDER MATTERS HERE !!!!
-          mEraVPar[era].push_back(*mEra_mStrJetCorPar[era]["L1JetPar"]);
-          mEraVPar[era].push_back(*mEra_mStrJetCorPar[era]["L2JetPar"]);
-          mEraVPar[era].push_back(*mEra_mStrJetCorPar[era]["L3JetPar"]);
-          mEraVPar[era].push_back(*mEra_mStrJetCorPar[era]["ResJetPar"]);
-          mEraVParAK8[era].push_back(*mEra_mStrJetCorPar[era]["L1JetParAK8"]);
-          mEraVParAK8[era].push_back(*mEra_mStrJetCorPar[era]["L2JetParAK8"]);
-          mEraVParAK8[era].push_back(*mEra_mStrJetCorPar[era]["L3JetParAK8"]);
-          mEraVParAK8[era].push_back(*mEra_mStrJetCorPar[era]["ResJetParAK8"]);
-
-          mEraFacJetCorr[era] = std::shared_ptr<FactorizedJetCorrector>( new FactorizedJetCorrector(mEraVPar[era]) );
-	  mEraFacJetCorrAK8[era] = std::shared_ptr<FactorizedJetCorrector> (new FactorizedJetCorrector(mEraVParAK8[era]) );
-
-      }
+      // Run ranges of the data eras, sorted by run. The era correctors are built by SetFacJetCorr
+      // the first time a run of the era is seen, so a job over one era only holds that era's parameters.
+      vEraIOV.clear();
+      addEraIOV("B", "B_V", 299330);
+      addEraIOV("C", "C_V", 302029);
+      addEraIOV("DE", "DE_V", 304827);
+      addEraIOV("F", "F_V", std::numeric_limits<unsigned int>::max());
+      mCurrentIOV = -1;
 
     }
 
 
 }
 
+void JetMETCorrHelper::addEraIOV(std::string const & era, std::string const & replaceStr, unsigned int lastRun)
+{
+    EraIOV iov;
+    iov.era      = era;
+    iov.firstRun = vEraIOV.empty() ? 0 : vEraIOV.back().lastRun+1;
+    iov.lastRun  = lastRun;
+
+    //Fetch the text files
+    mEraJetParStr[era]["DataL1JetParByIOV"]  = std::regex_replace(mJetParStr["DataL1JetPar"],std::regex("B_V"), replaceStr);
+    mEraJetParStr[era]["DataL2JetParByIOV"]  = std::regex_replace(mJetParStr["DataL2JetPar"],std::regex("B_V"), replaceStr);
+    mEraJetParStr[era]["DataL3JetParByIOV"]  = std::regex_replace(mJetParStr["DataL3JetPar"],std::regex("B_V"), replaceStr);
+    mEraJetParStr[era]["DataResJetParByIOV"]  = std::regex_replace(mJetParStr["DataResJetPar"],std::regex("B_V"), replaceStr);
+
+    mEraJetParStr[era]["DataL1JetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataL1JetParAK8"],std::regex("B_V"), replaceStr);
+    mEraJetParStr[era]["DataL2JetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataL2JetParAK8"],std::regex("B_V"), replaceStr);
+    mEraJetParStr[era]["DataL3JetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataL3JetParAK8"],std::regex("B_V"), replaceStr);
+    mEraJetParStr[era]["DataResJetParAK8ByIOV"]  = std::regex_replace(mJetParStr["DataResJetParAK8"],std::regex("B_V"), replaceStr);
+
+    if(debug) std::cout << mLegend << "Using JEC files DataL1JetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL1JetParByIOV"] << std::endl;
+    if(debug) std::cout << mLegend << "Using JEC files DataL2JetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL2JetParByIOV"] << std::endl;
+    if(debug) std::cout << mLegend << "Using JEC files DataL3JetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL3JetParByIOV"] << std::endl;
+    if(debug) std::cout << mLegend << "Using JEC files DataResJetParByIOV : era "+era+": " <<  mEraJetParStr[era]["DataResJetParByIOV"] << std::endl;
+
+    if(debug) std::cout << mLegend << "Using JEC files DataL1JetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL1JetParAK8ByIOV"] << std::endl;
+    if(debug) std::cout << mLegend << "Using JEC files DataL2JetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL2JetParAK8ByIOV"] << std::endl;
+    if(debug) std::cout << mLegend << "Using JEC files DataL3JetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataL3JetParAK8ByIOV"] << std::endl;
+    if(debug) std::cout << mLegend << "Using JEC files DataResJetParAK8ByIOV : era "+era+": " <<  mEraJetParStr[era]["DataResJetParAK8ByIOV"] << std::endl;
+
+    vEraIOV.push_back(iov);
+}
+
+void JetMETCorrHelper::loadEra(EraIOV & iov)
+{
+    std::cout << mLegend << "Loading data JEC for era " << iov.era << " (runs " << iov.firstRun << "-" << iov.lastRun << ")" << std::endl;
+
+    std::map<std::string, std::string> & files = mEraJetParStr[iov.era];
+
+    // Load the JetCorrectorParameter objects into a std::vector,
+    // IMPORTANT: THE ORDER MATTERS HERE !!!!
+    // The corrector keeps its own copy, the vectors are not needed afterwards.
+    std::vector<JetCorrectorParameters> vEraPar;
+    vEraPar.push_back(JetCorrectorParameters(files["DataL1JetParByIOV"]));
+    vEraPar.push_back(JetCorrectorParameters(files["DataL2JetParByIOV"]));
+    vEraPar.push_back(JetCorrectorParameters(files["DataL3JetParByIOV"]));
+    vEraPar.push_back(JetCorrectorParameters(files["DataResJetParByIOV"]));
+
+    std::vector<JetCorrectorParameters> vEraParAK8;
+    vEraParAK8.push_back(JetCorrectorParameters(files["DataL1JetParAK8ByIOV"]));
+    vEraParAK8.push_back(JetCorrectorParameters(files["DataL2JetParAK8ByIOV"]));
+    vEraParAK8.push_back(JetCorrectorParameters(files["DataL3JetParAK8ByIOV"]));
+    vEraParAK8.push_back(JetCorrectorParameters(files["DataResJetParAK8ByIOV"]));
+
+    iov.corrector    = std::shared_ptr<FactorizedJetCorrector>( new FactorizedJetCorrector(vEraPar) );
+    iov.correctorAK8 = std::shared_ptr<FactorizedJetCorrector>( new FactorizedJetCorrector(vEraParAK8) );
+    iov.domain       = JetCorrectionGuard::MakeDomain(vEraPar);
+    iov.domainAK8    = JetCorrectionGuard::MakeDomain(vEraParAK8);
+}
 
 //JET CORRECTION HELPER METHODS
 void JetMETCorrHelper::SetFacJetCorr(edm::EventBase const & event)
@@ -151,36 +171,30 @@ void JetMETCorrHelper::SetFacJetCorr(edm::EventBase const & event)
  *This function takes an event, looks up the correct JEC file, and produces the correct JetCorrector for JEC corrections.
  *JEC is run number dependent.
  *This first gets the run number for the event
- *It then pulls in the corersponding spring16_V10* file
+ *It then finds the era whose run range holds it, loading the era's files on first use
  *Then uses that.
  *
- * This is called in singleLepEventSelector
+ * This is called in the selector and the calculators with their own JetMETCorrHelper
  * */
 
 
-  int iRun   = event.id().run();
+  unsigned int iRun = event.id().run();
 
+  // consecutive events nearly always come from the same era
+  if(mCurrentIOV >= 0 && iRun >= vEraIOV[mCurrentIOV].firstRun && iRun <= vEraIOV[mCurrentIOV].lastRun) return;
 
-  if(iRun <= 299330){
-  	if(debug) std::cout << "\t\t\t using JEC for era B "<< std::endl;
-  	JetCorrector = mEraFacJetCorr["B"];
-  	JetCorrectorAK8 = mEraFacJetCorrAK8["B"];
-  }
-  else if(iRun <= 302029){
-  	if(debug) std::cout << "\t\t\t using JEC for era C "<< std::endl;
-  	JetCorrector = mEraFacJetCorr["C"];
-  	JetCorrectorAK8 = mEraFacJetCorrAK8["C"];
-  }
-  else if(iRun <= 304827){
-  	if(debug) std::cout << "\t\t\t using JEC for era DE "<< std::endl;
-  	JetCorrector = mEraFacJetCorr["DE"];
-  	JetCorrectorAK8 = mEraFacJetCorrAK8["DE"];
-  	}
-  else{
-  	if(debug) std::cout << "\t\t\t using JEC for era F "<< std::endl;
-  	JetCorrector = mEraFacJetCorr["F"];
-  	JetCorrectorAK8 = mEraFacJetCorrAK8["F"];
-  }
+  // first era whose last run is not before iRun; the last era is open-ended
+  std::vector<EraIOV>::iterator iov = std::lower_bound(vEraIOV.begin(), vEraIOV.end(), iRun,
+                                                       [](EraIOV const & a, unsigned int run) { return a.lastRun < run; });
+
+  if(!iov->corrector) loadEra(*iov);
+
+  if(debug) std::cout << "\t\t\t using JEC for era "+iov->era << std::endl;
+  JetCorrector = iov->corrector;
+  JetCorrectorAK8 = iov->correctorAK8;
+  mJetCorrectorDomain = iov->domain;
+  mJetCorrectorAK8Domain = iov->domainAK8;
+  mCurrentIOV = iov - vEraIOV.begin();
 
 }
 
@@ -214,178 +228,149 @@ pat::Jet JetMETCorrHelper::correctJetReturnPatJet(const pat::Jet & jet,
   if (reCorrectJet) correctedJet = jet.correctedJet(0);                 //copy original jet
   else correctedJet = jet;                                 //copy default corrected jet
 
-  double ptscale = 1.0;
-  double unc = 1.0;
-  double pt = correctedJet.pt();
-  double correction = 1.0;
+  double rho = getRho(event, rhoJetsToken);
+  double pt_raw = reCorrectJet ? (jet.jecFactor(0)*jet.p4()).pt() : 0.0;
 
-  edm::Handle<double> rhoHandle;
-  event.getByToken(rhoJetsToken, rhoHandle);
-  double rho = std::max(*(rhoHandle.product()), 0.0);
-
-  if ( isMc ){
-
-    if (reCorrectJet) {
-      // We need to undo the default corrections and then apply the new ones
-
-      double pt_raw = jet.correctedJet(0).pt();
-
-      if (doAK8Corr){
-		JetCorrectorAK8->setJetEta(jet.eta());
-		JetCorrectorAK8->setJetPt(pt_raw);
-		JetCorrectorAK8->setJetA(jet.jetArea());
-		JetCorrectorAK8->setRho(rho);
-
-		try{
-		  correction = JetCorrectorAK8->getCorrection();
-		}
-		catch(...){
-		  std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-		  std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-		  std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-		}
-      }
-
-      else{
-		JetCorrector->setJetEta(jet.eta());
-		JetCorrector->setJetPt(pt_raw);
-		JetCorrector->setJetA(jet.jetArea());
-		JetCorrector->setRho(rho);
-
-		try{
-		  correction = JetCorrector->getCorrection();
-		}
-		catch(...){
-		  std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-		  std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-		  std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-		}
-      }
-
-      correctedJet.scaleEnergy(correction);
-      pt = correctedJet.pt();
+  CorrectedJet record;
+  record.p4 = correctedJet.p4();
+  applyJES(jet, jet.eta(), pt_raw, rho, doAK8Corr, reCorrectJet, record);
+  if ( isMc ) applyJERAndUnc(jet, jet.eta(), jet.phi(), rho, doAK8Corr, syst, record);
 
-    }
+  correctedJet.setP4(record.p4);
 
-    Variation JERsystematic = Variation::NOMINAL;
-    if( syst==3) JERsystematic = Variation::UP;
-    if( syst==4) JERsystematic = Variation::DOWN;
+  return correctedJet;
+}
 
-    JME::JetParameters parameters;
-    parameters.setJetPt(pt);
-    parameters.setJetEta(correctedJet.eta());
-    parameters.setRho(rho);
-    double res = 0.0;
-    if(doAK8Corr) res = resolutionAK8.getResolution(parameters);
-    else res = resolution.getResolution(parameters);
-    double factor = resolution_SF.getScaleFactor(parameters,JERsystematic) - 1;
+CorrectedJet JetMETCorrHelper::correctJetRecord(const pat::Jet & jet,
+                                                unsigned int index,
+                                                const reco::Candidate::LorentzVector & rawP4,
+                                                bool cleaned,
+                                                edm::Event const & event,
+                                                edm::EDGetTokenT<double> rhoJetsToken,
+                                                bool doAK8Corr,
+                                                bool reCorrectJet,
+                                                unsigned int syst)
+{
+  // a cleaned jet starts from its raw (cleaned) four-momentum; it only gets JES if reCorrectJet,
+  // otherwise it stays raw (applyJES is a no-op), before JER and JEC uncertainty in MC
+  const reco::Candidate::LorentzVector & jetP4 = cleaned ? rawP4 : jet.p4();
 
-    const reco::GenJet * genJet = jet.genJet();
-    bool smeared = false;
-    if(genJet){
-      double deltaPt = fabs(genJet->pt() - pt);
-      double deltaR = reco::deltaR(genJet->p4(),correctedJet.p4());
-      if (deltaR < ((doAK8Corr) ? 0.4 : 0.2) && deltaPt <= 3*pt*res){
-		double gen_pt = genJet->pt();
-		double reco_pt = pt;
-		double deltapt = (reco_pt - gen_pt) * factor;
-		ptscale = max(0.0, (reco_pt + deltapt) / reco_pt);
-		smeared = true;
-      }
-    }
-    if (!smeared && factor>0) {
-      JERrand.SetSeed(abs(static_cast<int>(jet.phi()*1e4)));
-      ptscale = max(0.0, JERrand.Gaus(pt,sqrt(factor*(factor+2))*res*pt)/pt);
-    }
+  double rho = getRho(event, rhoJetsToken);
 
-    if (  syst==1 || syst==2) {
-      jecUnc->setJetEta(jet.eta());
-      jecUnc->setJetPt(pt*ptscale);
-
-      if ( syst==1) {
-	try{
-	  unc = jecUnc->getUncertainty(true);
-	}
-	catch(...){ // catch all exceptions. Jet Uncertainty tool throws when binning out of range
-	  std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-	  std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-	  std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-	  unc = 0.0;
-	}
-	unc = 1 + unc;
-      }
-      else {
-	try{
-	  unc = jecUnc->getUncertainty(false);
-	}
-	catch(...){
-	  std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-	  std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-	  std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-	  unc = 0.0;
-	}
-	unc = 1 - unc;
-      }
-
-      if (pt*ptscale < 10.0 && ( syst==1)) unc = 2.0;
-      if (pt*ptscale < 10.0 && ( syst==2)) unc = 0.01;
+  CorrectedJet record;
+  record.index   = index;
+  record.cleaned = cleaned;
+  record.p4      = (reCorrectJet || cleaned) ? rawP4 : jet.p4();
 
-    }
+  applyJES(jet, jetP4.eta(), rawP4.pt(), rho, doAK8Corr, reCorrectJet, record);
 
-    correctedJet.scaleEnergy(unc*ptscale);
+  if (!reCorrectJet && !cleaned && jet.jecSetsAvailable()) {
+    // keep the factors the jet was produced with
+    record.jec = 1.0/jet.jecFactor(0);
+    std::vector<std::string> levels = jet.availableJECLevels();
+    if (std::find(levels.begin(), levels.end(), "L1FastJet") != levels.end()) record.jecL1 = jet.jecFactor("L1FastJet")/jet.jecFactor(0);
+  }
 
+  if ( !isMc ) return record;
+
+  applyJERAndUnc(jet, jetP4.eta(), jetP4.phi(), rho, doAK8Corr, syst, record);
+
+  return record;
+}
+
+double JetMETCorrHelper::getRho(edm::Event const & event, edm::EDGetTokenT<double> rhoJetsToken)
+{
+  edm::Handle<double> rhoHandle;
+  event.getByToken(rhoJetsToken, rhoHandle);
+  return std::max(*(rhoHandle.product()), 0.0);
+}
+
+void JetMETCorrHelper::applyJES(const pat::Jet & jet,
+                                double eta,
+                                double pt_raw,
+                                double rho,
+                                bool doAK8Corr,
+                                bool reCorrectJet,
+                                CorrectedJet & record)
+{
+  if (!reCorrectJet) return;
+
+  // We need to undo the default corrections and then apply the new ones
+  std::shared_ptr<FactorizedJetCorrector> & corrector = doAK8Corr ? JetCorrectorAK8 : JetCorrector;
+  JetCorrectionGuard::Domain const & domain = doAK8Corr ? mJetCorrectorAK8Domain : mJetCorrectorDomain;
+
+  std::vector<float> corrVec;
+  if ( mGuard.SubCorrections(*corrector, domain, eta, pt_raw, jet.jetArea(), rho, corrVec) == JetCorrectionGuard::kOk ) {
+    record.jecL1 = corrVec.front();
+    record.jec   = corrVec.back();
   }
-  else if (!isMc) {
-
-    if (reCorrectJet) {
-
-      double pt_raw = jet.correctedJet(0).pt();
-      // We need to undo the default corrections and then apply the new ones
-
-      if (doAK8Corr){
-		JetCorrectorAK8->setJetEta(jet.eta());
-		JetCorrectorAK8->setJetPt(pt_raw);
-		JetCorrectorAK8->setJetA(jet.jetArea());
-		JetCorrectorAK8->setRho(rho);
-
-		try{
-		  correction = JetCorrectorAK8->getCorrection();
-		}
-		catch(...){
-		  std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-		  std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-		  std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-		}
-      }
-
-      else{
-		JetCorrector->setJetEta(jet.eta());
-		JetCorrector->setJetPt(pt_raw);
-		JetCorrector->setJetA(jet.jetArea());
-		JetCorrector->setRho(rho);
-
-		try{
-		  correction = JetCorrector->getCorrection();
-		}
-		catch(...){
-		  std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-		  std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-		  std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-		}
-      }
-      correctedJet.scaleEnergy(correction);
-      pt = correctedJet.pt();
 
+  double correction = record.jec;
+  record.p4 *= correction;
+}
+
+void JetMETCorrHelper::applyJERAndUnc(const pat::Jet & jet,
+                                      double eta,
+                                      double phi,
+                                      double rho,
+                                      bool doAK8Corr,
+                                      unsigned int syst,
+                                      CorrectedJet & record)
+{
+  double ptscale = 1.0;
+  double unc = 1.0;
+  double pt = record.p4.pt();
+
+  Variation JERsystematic = Variation::NOMINAL;
+  if( syst==3) JERsystematic = Variation::UP;
+  if( syst==4) JERsystematic = Variation::DOWN;
+
+  JME::JetParameters parameters;
+  parameters.setJetPt(pt);
+  parameters.setJetEta(record.p4.eta());
+  parameters.setRho(rho);
+  double res = 0.0;
+  if(doAK8Corr) res = resolutionAK8.getResolution(parameters);
+  else res = resolution.getResolution(parameters);
+  double factor = resolution_SF.getScaleFactor(parameters,JERsystematic) - 1;
+
+  const reco::GenJet * genJet = jet.genJet();
+  bool smeared = false;
+  if(genJet){
+    double deltaPt = fabs(genJet->pt() - pt);
+    double deltaR = reco::deltaR(genJet->p4(),record.p4);
+    if (deltaR < ((doAK8Corr) ? 0.4 : 0.2) && deltaPt <= 3*pt*res){
+      double gen_pt = genJet->pt();
+      double reco_pt = pt;
+      double deltapt = (reco_pt - gen_pt) * factor;
+      ptscale = max(0.0, (reco_pt + deltapt) / reco_pt);
+      smeared = true;
     }
   }
+  if (!smeared && factor>0) {
+    JERrand.SetSeed(abs(static_cast<int>(phi*1e4)));
+    ptscale = max(0.0, JERrand.Gaus(pt,sqrt(factor*(factor+2))*res*pt)/pt);
+  }
 
-  return correctedJet;
+  if (  syst==1 || syst==2) {
+    mGuard.Uncertainty(*jecUnc, mJecUncDomain, eta, pt*ptscale, syst==1, unc);
+    unc = (syst==1) ? 1 + unc : 1 - unc;
+
+    if (pt*ptscale < 10.0 && ( syst==1)) unc = 2.0;
+    if (pt*ptscale < 10.0 && ( syst==2)) unc = 0.01;
+
+  }
+
+  record.jer = ptscale;
+  record.unc = unc;
+  double scale = unc*ptscale;
+  record.p4 *= scale;
 }
 
 TLorentzVector JetMETCorrHelper::correctMet(const pat::MET & met,
                                                  edm::Event const & event,
                                                  edm::EDGetTokenT<double> rhoJetsToken,
-                                                 std::vector<edm::Ptr<pat::Jet>> vAllJets,
+                                                 std::vector<edm::Ptr<pat::Jet>> const & vAllJets,
                                                  bool reCorrectjet,
                                                  unsigned int syst,
                                                  bool useHF)
@@ -412,22 +397,69 @@ TLorentzVector JetMETCorrHelper::correctMet(const pat::MET & met,
     return correctedMET_p4_temp;
 }
 
+void JetMETCorrHelper::correctMetType1(edm::Event const & event,
+                                       edm::EDGetTokenT<double> rhoJetsToken,
+                                       std::vector<edm::Ptr<pat::Jet>> const & vAllJets,
+                                       bool reCorrectjet,
+                                       unsigned int syst,
+                                       bool allSyst,
+                                       Type1MET & type1)
+{
+    type1.Reset(reCorrectjet);
+    if ( !reCorrectjet ) return;
+
+    bool want[Type1MET::nVariations] = {false, false, false, false, false};
+    want[syst] = true;
+    if ( allSyst ) {
+        for (int v = Type1MET::kJECup; v <= Type1MET::kJERdown; v++) want[v] = true;
+    }
+
+    double rho = getRho(event, rhoJetsToken);
+
+    type1.vJets.resize(vAllJets.size());
+    TLorentzVector delta[Type1MET::nVariations];
+    for (unsigned int ijet = 0; ijet < vAllJets.size(); ijet++) {
+        const pat::Jet & jet = *vAllJets[ijet];
+        metDeltas(jet, rho, want, delta);
+
+        Type1MET::JetDelta & jetDelta = type1.vJets[ijet];
+        jetDelta.central = !(fabs(jet.eta())>2.6);
+        for (int v = 0; v < Type1MET::nVariations; v++) {
+            jetDelta.px[v] = delta[v].Px();
+            jetDelta.py[v] = delta[v].Py();
+        }
+    }
+
+    for (int v = 0; v < Type1MET::nVariations; v++) type1.computed[v] = want[v];
+}
+
 TLorentzVector JetMETCorrHelper::correctJetForMet(const pat::Jet & jet,
                                                        edm::Event const & event,
                                                        edm::EDGetTokenT<double> rhoJetsToken,
                                                        unsigned int syst)
 {
+    bool want[Type1MET::nVariations] = {false, false, false, false, false};
+    want[syst] = true;
 
-    TLorentzVector jetP4, offJetP4;
-    jetP4.SetPtEtaPhiM(0.000001,1.,1.,0.000001);
+    TLorentzVector delta[Type1MET::nVariations];
+    metDeltas(jet, getRho(event, rhoJetsToken), want, delta);
 
-    if ( jet.chargedEmEnergyFraction() + jet.neutralEmEnergyFraction() > 0.90 ) {
-        return jetP4-jetP4;
-    }
+    return delta[syst];
+}
 
-    pat::Jet correctedJet = jet.correctedJet(0);                 //copy original jet
+void JetMETCorrHelper::metDeltas(const pat::Jet & jet,
+                                 double rho,
+                                 bool const (&want)[Type1MET::nVariations],
+                                 TLorentzVector (&delta)[Type1MET::nVariations])
+{
+    for (int v = 0; v < Type1MET::nVariations; v++) delta[v].SetPxPyPzE(0., 0., 0., 0.);
 
-    jetP4.SetPtEtaPhiM(correctedJet.pt(),correctedJet.eta(),correctedJet.phi(),correctedJet.mass());
+    if ( jet.chargedEmEnergyFraction() + jet.neutralEmEnergyFraction() > 0.90 ) return;
+
+    reco::Candidate::LorentzVector rawP4 = jet.jecFactor(0)*jet.p4(); // p4 of jet.correctedJet(0), without copying the jet
+
+    TLorentzVector jetP4, offJetP4;
+    jetP4.SetPtEtaPhiM(rawP4.pt(),rawP4.eta(),rawP4.phi(),rawP4.mass());
 
     const std::vector<reco::CandidatePtr> & cands = jet.daughterPtrVector();
     for ( std::vector<reco::CandidatePtr>::const_iterator cand = cands.begin(); cand != cands.end(); ++cand ) {
@@ -441,130 +473,83 @@ TLorentzVector JetMETCorrHelper::correctJetForMet(const pat::Jet & jet,
     }
     offJetP4 = jetP4;
 
-    double ptscale = 1.0;
-    double unc = 1.0;
-    double pt = correctedJet.pt();
+    // L1 and L123 from one evaluation of the corrector, shared by all variations
     std::vector<float> corrVec;
 
-    edm::Handle<double> rhoHandle;
-    event.getByToken(rhoJetsToken, rhoHandle);
-    double rho = std::max(*(rhoHandle.product()), 0.0);
+    mGuard.SubCorrections(*JetCorrector, mJetCorrectorDomain, rawP4.eta(), rawP4.pt(), jet.jetArea(), rho, corrVec);
 
-    if ( isMc ){
+    jetP4 *= corrVec[corrVec.size()-1];
+    offJetP4 *= corrVec[0];
 
-        JetCorrector->setJetEta(correctedJet.eta());
-  		JetCorrector->setJetPt(pt);
-        JetCorrector->setJetA(jet.jetArea());
-  		JetCorrector->setRho(rho);
+    // JER smearing x JEC uncertainty of each variation, 1 for data
+    double scale[Type1MET::nVariations] = {1.0, 1.0, 1.0, 1.0, 1.0};
 
-        try{
-    	    corrVec = JetCorrector->getSubCorrections();
-        }
-  		catch(...){
-    	    std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-    	    std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-    	    std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-        }
-
-        jetP4 *= corrVec[corrVec.size()-1];
-        offJetP4 *= corrVec[0];
-        pt = jetP4.Pt();
-
-        Variation JERsystematic = Variation::NOMINAL;
-        if(syst==3) JERsystematic = Variation::UP;
-        if(syst==4) JERsystematic = Variation::DOWN;
+    if ( isMc ){
 
         JME::JetParameters parameters;
-        parameters.setJetPt(pt);
+        parameters.setJetPt(jetP4.Pt());
         parameters.setJetEta(jetP4.Eta());
         parameters.setRho(rho);
-        double res = 0.0;
-        res = resolution.getResolution(parameters);
-        double factor = resolution_SF.getScaleFactor(parameters,JERsystematic) - 1;
-
-        const reco::GenJet * genJet = jet.genJet();
-        bool smeared = false;
-        if(genJet){
-            TLorentzVector genP4;
-            genP4.SetPtEtaPhiE(genJet->pt(),genJet->eta(),genJet->phi(),genJet->energy());
-            double deltaPt = fabs(genJet->pt() - pt);
-            double deltaR = jetP4.DeltaR(genP4);
-            if (deltaR < 0.2 && deltaPt <= 3*pt*res){
-               double gen_pt = genJet->pt();
-               double reco_pt = pt;
-               double deltapt = (reco_pt - gen_pt) * factor;
-               ptscale = max(0.0, (reco_pt + deltapt) / reco_pt);
-               smeared = true;
-            }
-        }
-        if (!smeared && factor>0) {
-          JERrand.SetSeed(abs(static_cast<int>(jet.phi()*1e4)));
-          ptscale = max(0.0, JERrand.Gaus(pt,sqrt(factor*(factor+2))*res*pt)/pt);
+        double res = resolution.getResolution(parameters);
+
+        if ( want[Type1MET::kNominal] || want[Type1MET::kJECup] || want[Type1MET::kJECdown] ) {
+            double ptscale = jerScaleForMet(jet, jetP4, res, resolution_SF.getScaleFactor(parameters,Variation::NOMINAL) - 1);
+            scale[Type1MET::kNominal] = ptscale;
+            if ( want[Type1MET::kJECup] )   scale[Type1MET::kJECup]   = jecUncForMet(jetP4, ptscale, true)*ptscale;
+            if ( want[Type1MET::kJECdown] ) scale[Type1MET::kJECdown] = jecUncForMet(jetP4, ptscale, false)*ptscale;
         }
+        if ( want[Type1MET::kJERup] )   scale[Type1MET::kJERup]   = jerScaleForMet(jet, jetP4, res, resolution_SF.getScaleFactor(parameters,Variation::UP) - 1);
+        if ( want[Type1MET::kJERdown] ) scale[Type1MET::kJERdown] = jerScaleForMet(jet, jetP4, res, resolution_SF.getScaleFactor(parameters,Variation::DOWN) - 1);
 
-        if ( syst==1 || syst==2) {
-            jecUnc->setJetEta(jetP4.Eta());
-            jecUnc->setJetPt(jetP4.Pt()*ptscale);
-
-            if (syst==1) {
-                try{
-                    unc = jecUnc->getUncertainty(true);
-                }
-                catch(...){ // catch all exceptions. Jet Uncertainty tool throws when binning out of range
-                    std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-                    std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-                    std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-                    unc = 0.0;
-                }
-                unc = 1 + unc;
-            }
-            else {
-                try{
-                    unc = jecUnc->getUncertainty(false);
-                }
-                catch(...){
-                    std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-                    std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-                    std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-                    unc = 0.0;
-                }
-                unc = 1 - unc;
-            }
-            if (jetP4.Pt()*ptscale < 10.0 && (syst==1)) unc = 2.0;
-            if (jetP4.Pt()*ptscale < 10.0 && (syst==2)) unc = 0.01;
+    }
 
+    for (int v = 0; v < Type1MET::nVariations; v++) {
+        if ( !want[v] ) continue;
+        TLorentzVector corrP4 = jetP4*scale[v];
+        TLorentzVector offP4 = offJetP4*scale[v];
+        if (corrP4.Pt()<=15.) {
+            offP4 = corrP4;
         }
-
+        delta[v] = offP4-corrP4;
     }
-    else if (!isMc) {
+}
 
-        JetCorrector->setJetEta(correctedJet.eta());
-        JetCorrector->setJetPt(pt);
-        JetCorrector->setJetA(jet.jetArea());
-        JetCorrector->setRho(rho);
+double JetMETCorrHelper::jerScaleForMet(const pat::Jet & jet, const TLorentzVector & jetP4, double res, double factor)
+{
+    double ptscale = 1.0;
+    double pt = jetP4.Pt();
 
-        try{
-    	    corrVec = JetCorrector->getSubCorrections();
-        }
-        catch(...){
-           std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-           std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-           std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
+    const reco::GenJet * genJet = jet.genJet();
+    bool smeared = false;
+    if(genJet){
+        TLorentzVector genP4;
+        genP4.SetPtEtaPhiE(genJet->pt(),genJet->eta(),genJet->phi(),genJet->energy());
+        double deltaPt = fabs(genJet->pt() - pt);
+        double deltaR = jetP4.DeltaR(genP4);
+        if (deltaR < 0.2 && deltaPt <= 3*pt*res){
+           double gen_pt = genJet->pt();
+           double reco_pt = pt;
+           double deltapt = (reco_pt - gen_pt) * factor;
+           ptscale = max(0.0, (reco_pt + deltapt) / reco_pt);
+           smeared = true;
         }
+    }
+    if (!smeared && factor>0) {
+      JERrand.SetSeed(abs(static_cast<int>(jet.phi()*1e4)));
+      ptscale = max(0.0, JERrand.Gaus(pt,sqrt(factor*(factor+2))*res*pt)/pt);
+    }
 
+    return ptscale;
+}
 
-        jetP4 *= corrVec[corrVec.size()-1];
-        offJetP4 *= corrVec[0];
-        pt = jetP4.Pt();
-
-    }
+double JetMETCorrHelper::jecUncForMet(const TLorentzVector & jetP4, double ptscale, bool up)
+{
+    double unc = 0.0;
+    mGuard.Uncertainty(*jecUnc, mJecUncDomain, jetP4.Eta(), jetP4.Pt()*ptscale, up, unc);
+    unc = up ? 1 + unc : 1 - unc;
 
-    jetP4 *= unc*ptscale;
-    offJetP4 *= unc*ptscale;
-    if (jetP4.Pt()<=15.) {
-        offJetP4 = jetP4;
-    }
+    if (jetP4.Pt()*ptscale < 10.0) unc = up ? 2.0 : 0.01;
 
-    return offJetP4-jetP4;
+    return unc;
 }
 
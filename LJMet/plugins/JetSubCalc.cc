@@ -68,7 +68,6 @@ private:
   bool   JERdown;
   bool   doNewJEC;
   bool   doAllJetSyst;
-  JetMETCorrHelper JetMETCorr;
 
   BTagSFUtil btagSfUtil;
 
@@ -92,6 +91,9 @@ int JetSubCalc::BeginJob(edm::ConsumesCollector && iC)
 
   genParticlesToken   = iC.consumes<reco::GenParticleCollection>(mPset.getParameter<edm::InputTag>("genParticles"));
 
+  DeclareUse(BaseEventSelector::kSelCorrJets);
+  DeclareUse(BaseEventSelector::kSelCorrJetsAK8);
+
   //HARDCODING !
   bDiscriminant    = "pfDeepCSVJetTags:probb";
   bbDiscriminant   = "pfDeepCSVJetTags:probbb";
@@ -122,7 +124,7 @@ int JetSubCalc::BeginJob(edm::ConsumesCollector && iC)
   JERdown                  = mPset.getParameter<bool>("JERdown");
   doNewJEC                 = mPset.getParameter<bool>("doNewJEC");
   doAllJetSyst             = mPset.getParameter<bool>("doAllJetSyst");
-  JetMETCorr.Initialize(mPset); // REMINDER: THIS NEEDS --if(!isMc)JetMETCorr.SetFacJetCorr(event)-- somewhere correcting jets for data, since data JEC is era dependent. !!
+  // SoftDrop subjets are corrected by the selector (BaseEventSelector::GetAK8Features), no JEC files loaded here
 
   //BTAG parameter initialization
   btagSfUtil.Initialize(mPset);
@@ -134,12 +136,11 @@ int JetSubCalc::BeginJob(edm::ConsumesCollector && iC)
 int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selector)
 {
 
-    if(!isMc) JetMETCorr.SetFacJetCorr(event);
-
     // ----- Get AK4 jet objects from the selector -----
     // This is updated -- original version used all AK4 jets without selection
     std::vector<pat::Jet>                       const & theJets = selector->GetSelCorrJets();
     std::vector<pat::Jet>                       const & theAK8Jets = selector->GetSelCorrJetsAK8();
+    AK8FeatureCache                                   & ak8FeatureCache = selector->GetAK8Features();
 
     double theJetHT = 0;
 
@@ -368,11 +369,12 @@ int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selec
 
       if (ii->pt() < 170) continue;
 
-      pat::Jet corrak8;
-      corrak8 = *ii;
+      pat::Jet const & corrak8 = *ii;
 
       if(killHF && fabs(corrak8.eta()) > 2.4) continue;
 
+      AK8FeatureCache::JetFeatures const & ak8Features = ak8FeatureCache.Get(index);
+
       theJetAK8Pt    .push_back(corrak8.pt());
       theJetAK8Eta   .push_back(corrak8.eta());
       theJetAK8Phi   .push_back(corrak8.phi());
@@ -415,14 +417,14 @@ int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selec
 
       theCHSPrunedMass   = (double)corrak8.userFloat("ak8PFJetsCHSValueMap:ak8PFJetsCHSPrunedMass");
       theCHSSoftDropMass = (double)corrak8.userFloat("ak8PFJetsCHSValueMap:ak8PFJetsCHSSoftDropMass");
-      theSoftDrop = (double)corrak8.userFloat("ak8PFJetsPuppiSoftDropMass");
+      theSoftDrop = ak8Features.softDropMassPuppi;
 
       theNjettinessTau1 = std::numeric_limits<double>::max();
       theNjettinessTau2 = std::numeric_limits<double>::max();
       theNjettinessTau3 = std::numeric_limits<double>::max();
-      theNjettinessTau1 = (double)corrak8.userFloat("NjettinessAK8Puppi:tau1");
-      theNjettinessTau2 = (double)corrak8.userFloat("NjettinessAK8Puppi:tau2");
-      theNjettinessTau3 = (double)corrak8.userFloat("NjettinessAK8Puppi:tau3");
+      theNjettinessTau1 = ak8Features.tau1;
+      theNjettinessTau2 = ak8Features.tau2;
+      theNjettinessTau3 = ak8Features.tau3;
 
       theCHSTau1 = std::numeric_limits<double>::max();
       theCHSTau2 = std::numeric_limits<double>::max();
@@ -459,25 +461,12 @@ int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selec
       theJetAK8SoftDropn3b1.push_back(theSoftDropn3b1);
       theJetAK8SoftDropn3b2.push_back(theSoftDropn3b2);
 
-      theJetAK8nDaughters.push_back((int)corrak8.numberOfDaughters());
+      theJetAK8nDaughters.push_back((int)ak8Features.nDaughters);
       theJetAK8Index.push_back(index);
 
       //JetCharge calculation
 
-      reco::Jet::Constituents constituents = corrak8.getJetConstituents();
-
-      double sumWeightedCharge = 0.0;
-      int con_charge = 0;
-      double con_pt = 0.0;
-      for(auto constituentItr=constituents.begin(); constituentItr!=constituents.end(); ++constituentItr){
-        edm::Ptr<reco::Candidate> constituent=*constituentItr;
-
-        con_charge = (int)constituent->charge();
-        con_pt     = (double)constituent->pt();
-
-        sumWeightedCharge = sumWeightedCharge + ( con_charge * pow(con_pt,kappa) );
-
-      }
+      double sumWeightedCharge = ak8FeatureCache.ConstituentChargeSum(index, kappa);
 
       jetCharge  = 1.0/( pow( (corrak8.pt()), kappa) ) * sumWeightedCharge;
 
@@ -493,33 +482,16 @@ int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selec
       nSDSubsDeepCSVM_lSFup = 0;
       nSDSubsDeepCSVM_lSFdn = 0;
 
-      TLorentzVector puppi_softdrop, puppi_softdrop_subjet;
       std::vector<std::string> labels = corrak8.subjetCollectionNames();
       if(labels.size() == 0) std::cout << "there are no subjet collection labels" << std::endl;
       // for (unsigned int j = 0; j < labels.size(); j++){
       //        std::cout << labels.at(j) << std::endl;
       // }
-      auto const & sdSubjets = corrak8.subjets("SoftDropPuppi");
-      //auto const & sdSubjets = corrak8.subjets("SoftDrop");
+      // subjets come corrected (selector JEC) and b-tagged from the selector's AK8 feature cache
+      auto const & sdSubjets = ak8Features.subjets;
       nSDSubJets = (int)sdSubjets.size();
       //std::cout << "Found " << nSDSubJets << " subjets" << std::endl;
-      for ( auto const & it : sdSubjets ) {
-
-        puppi_softdrop_subjet.SetPtEtaPhiM(it->correctedP4(0).pt(),it->correctedP4(0).eta(),it->correctedP4(0).phi(),it->correctedP4(0).mass());
-        puppi_softdrop+=puppi_softdrop_subjet;
-
-
-        //for jet correction
-        unsigned int syst;
-        if (JECup){syst=1;}
-        else if (JECdown){syst=2;}
-        else if (JERup){syst=3;}
-        else if (JERdown){syst=4;}
-        else syst = 0; //nominal
-        bool isAK8 = false;
-
-        pat::Jet corrsubjet;
-        corrsubjet = JetMETCorr.correctJetReturnPatJet(*it, event, rhoJetsToken, isAK8, doNewJEC, syst);
+      for ( auto const & sdSubjet : sdSubjets ) {
 
 
         SDsubjetPt          = -std::numeric_limits<double>::max();
@@ -532,27 +504,25 @@ int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selec
         SDsubjetDeepCSVbb   = -std::numeric_limits<double>::max();
         SDdeltaRsubjetJet   = std::numeric_limits<double>::max();
 
-        SDsubjetPt           = corrsubjet.pt();
-        SDsubjetEta          = corrsubjet.eta();
-        SDsubjetPhi          = corrsubjet.phi();
-        SDsubjetMass         = corrsubjet.mass();
-        SDsubjetDeepCSVb     = corrsubjet.bDiscriminator(bDiscriminant);
-        SDsubjetDeepCSVbb    = corrsubjet.bDiscriminator(bbDiscriminant);
-        SDsubjetDeepCSVc     = corrsubjet.bDiscriminator(cDiscriminant);
-        SDsubjetDeepCSVudsg  = corrsubjet.bDiscriminator(udsgDiscriminant);
-        SDsubjetHFlav        = corrsubjet.hadronFlavour();
-
-        TLorentzVector subjetP4; subjetP4.SetPtEtaPhiE(ii->pt(), ii->eta(), ii->phi(), ii->energy() );
-
-        SDsubjetBTag         = btagSfUtil.isJetTagged(corrsubjet, subjetP4, event, isMc, 0, true);
+        SDsubjetPt           = sdSubjet.pt;
+        SDsubjetEta          = sdSubjet.eta;
+        SDsubjetPhi          = sdSubjet.phi;
+        SDsubjetMass         = sdSubjet.mass;
+        SDsubjetDeepCSVb     = sdSubjet.subjet->bDiscriminator(bDiscriminant);
+        SDsubjetDeepCSVbb    = sdSubjet.subjet->bDiscriminator(bbDiscriminant);
+        SDsubjetDeepCSVc     = sdSubjet.subjet->bDiscriminator(cDiscriminant);
+        SDsubjetDeepCSVudsg  = sdSubjet.subjet->bDiscriminator(udsgDiscriminant);
+        SDsubjetHFlav        = sdSubjet.hadronFlavour;
+
+        SDsubjetBTag         = sdSubjet.btag[0];
         SDdeltaRsubjetJet    = deltaR(corrak8.eta(), corrak8.phi(), SDsubjetEta, SDsubjetPhi);
 
         if(SDsubjetDeepCSVb + SDsubjetDeepCSVbb > 0.1522) nSDSubsDeepCSVL++;
         if(SDsubjetBTag > 0) nSDSubsDeepCSVMSF++;
-        if(btagSfUtil.isJetTagged(corrsubjet, subjetP4, event, isMc, 1, true) > 0) nSDSubsDeepCSVM_bSFup++;
-        if(btagSfUtil.isJetTagged(corrsubjet, subjetP4, event, isMc, 2, true) > 0) nSDSubsDeepCSVM_bSFdn++;
-        if(btagSfUtil.isJetTagged(corrsubjet, subjetP4, event, isMc, 3, true) > 0) nSDSubsDeepCSVM_lSFup++;
-        if(btagSfUtil.isJetTagged(corrsubjet, subjetP4, event, isMc, 4, true) > 0) nSDSubsDeepCSVM_lSFdn++;
+        if(sdSubjet.btag[1]) nSDSubsDeepCSVM_bSFup++;
+        if(sdSubjet.btag[2]) nSDSubsDeepCSVM_bSFdn++;
+        if(sdSubjet.btag[3]) nSDSubsDeepCSVM_lSFup++;
+        if(sdSubjet.btag[4]) nSDSubsDeepCSVM_lSFdn++;
 
         theJetAK8SDSubjetPt.push_back(SDsubjetPt);
         theJetAK8SDSubjetEta.push_back(SDsubjetEta);
@@ -588,7 +558,7 @@ int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selec
 
       puppicorr = genCorr * recoCorr;
 
-      theSoftDrop = puppi_softdrop.M();
+      theSoftDrop = ak8Features.softDropRawP4.M();
       double theSoftDropCorrected = theSoftDrop*puppicorr;
 
       double jmr_sd = 1.0;
@@ -732,7 +702,10 @@ int JetSubCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selec
     edm::Handle<reco::GenParticleCollection> genParticles;
     if(isMc && event.getByToken(genParticlesToken, genParticles)){
 
-      for(size_t i = 0; i < genParticles->size(); i++){
+      std::vector<unsigned int> candidates;
+      selector->GetGenParticleIndex(genParticles).SelectAbsPdgIds({6, 23, 24, 25}, candidates);
+
+      for(size_t i : candidates){
         const reco::GenParticle &p = (*genParticles).at(i);
         int id = p.pdgId();
 
@@ -0,0 +1,47 @@
+#include "FWLJMET/LJMet/interface/LHESummary.h"
+
+#include <cmath>
+#include <cstdlib>
+
+
+LHESummary::LHESummary():
+    mBuilt(false),
+    mHT(0),
+    mNPartons(0),
+    mNB(0),
+    mNC(0),
+    mLeadingPartonPt(0)
+{
+}
+
+
+void LHESummary::Build(edm::Handle<LHEEventProduct> const & lheEvent)
+{
+    mProductId = lheEvent.id();
+    mBuilt     = true;
+
+    mHT              = 0;
+    mNPartons        = 0;
+    mNB              = 0;
+    mNC              = 0;
+    mLeadingPartonPt = 0;
+
+    // read the HEPEUP arrays in place
+    lhef::HEPEUP const & hepeup = lheEvent->hepeup();
+    for(unsigned int i = 0, n = hepeup.PUP.size(); i < n; i++){
+        if(hepeup.ISTUP[i] != 1) continue;
+
+        int absPdgId = std::abs(hepeup.IDUP[i]);
+        if(!((absPdgId >= 1 && absPdgId <= 6) || absPdgId == 21)) continue;
+
+        double px = hepeup.PUP[i][0];
+        double py = hepeup.PUP[i][1];
+        double pt = std::sqrt(px*px + py*py);
+
+        mHT += pt;
+        mNPartons++;
+        if(absPdgId == 5) mNB++;
+        if(absPdgId == 4) mNC++;
+        if(pt > mLeadingPartonPt) mLeadingPartonPt = pt;
+    }
+}
@@ -0,0 +1,103 @@
+#include "FWLJMET/LJMet/interface/LHEWeightSchema.h"
+
+#include <cstdlib>
+
+
+LHEWeightSchema::LHEWeightSchema():
+    mLegend("\t[LHEWeightSchema]: "),
+    mResolved(false),
+    mRun(0)
+{
+}
+
+
+void LHEWeightSchema::SetKeepRanges(std::vector<int> const & ranges)
+{
+    mvKeepRanges.clear();
+    if(ranges.size() % 2 != 0){
+        std::cout << mLegend << "Odd number of entries in the weight id ranges, ignoring the last one" << std::endl;
+    }
+    for(unsigned int i = 0; i+1 < ranges.size(); i += 2){
+        mvKeepRanges.push_back(std::make_pair(ranges[i], ranges[i+1]));
+    }
+    mResolved = false;
+}
+
+
+bool LHEWeightSchema::keep(int id) const
+{
+    if(mvKeepRanges.empty()) return true;
+    for(auto const & range : mvKeepRanges){
+        if(id >= range.first && id <= range.second) return true;
+    }
+    return false;
+}
+
+
+bool LHEWeightSchema::fingerprintMatches(std::vector<gen::WeightsInfo> const & weights) const
+{
+    return weights.size() == mvAllIds.size()
+        && (weights.empty() || (weights.front().id == mvAllIds.front() && weights.back().id == mvAllIds.back()));
+}
+
+
+bool LHEWeightSchema::matches(std::vector<gen::WeightsInfo> const & weights) const
+{
+    if(weights.size() != mvAllIds.size()) return false;
+    for(unsigned int i = 0; i < weights.size(); i++){
+        if(weights[i].id != mvAllIds[i]) return false;
+    }
+    return true;
+}
+
+
+void LHEWeightSchema::Update(unsigned int run, std::vector<gen::WeightsInfo> const & weights)
+{
+    if(mResolved && fingerprintMatches(weights)){
+        if(run == mRun) return;
+        // new run: check every id once before keeping the layout
+        mRun = run;
+        if(matches(weights)) return;
+    }
+
+    mRun = run;
+    resolve(weights);
+}
+
+
+void LHEWeightSchema::resolve(std::vector<gen::WeightsInfo> const & weights)
+{
+    mvSlots.clear();
+    mvIds.clear();
+
+    unsigned int nBadIds = 0;
+    for(unsigned int i = 0; i < weights.size(); i++){
+        char * end = 0;
+        long id = std::strtol(weights[i].id.c_str(), &end, 10);
+        if(end == weights[i].id.c_str() || *end != '\0'){
+            nBadIds++;
+            continue;
+        }
+        if(!keep(id)) continue;
+        mvSlots.push_back(i);
+        mvIds.push_back(id);
+    }
+
+    mvAllIds.resize(weights.size());
+    for(unsigned int i = 0; i < weights.size(); i++) mvAllIds[i] = weights[i].id;
+    mResolved = true;
+
+    std::cout << mLegend << "Run " << mRun << ": keeping " << mvIds.size() << " of " << mvAllIds.size() << " LHE weights" << std::endl;
+    if(nBadIds > 0){
+        std::cout << mLegend << "Skipped " << nBadIds << " weights with non-integer ids" << std::endl;
+    }
+}
+
+
+void LHEWeightSchema::Fill(std::vector<gen::WeightsInfo> const & weights, double norm, std::vector<double> & out) const
+{
+    out.resize(mvSlots.size());
+    for(unsigned int k = 0; k < mvSlots.size(); k++){
+        out[k] = weights[mvSlots[k]].wgt / norm;
+    }
+}
@@ -34,6 +34,7 @@
 
 
 #include "TTree.h"
+#include "TH2F.h"
 
 // Adding TFile service stuff -- https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuideTFileService, https://github.com/cms-sw/cmssw/blob/CMSSW_9_4_X/FWCore/Skeletons/scripts/mkTemplates/EDAnalyzer/EDAnalyzer.cc
 #include "FWCore/ServiceRegistry/interface/Service.h"
@@ -42,6 +43,8 @@
 #include "FWLJMET/LJMet/interface/LjmetEventContent.h"
 #include "FWLJMET/LJMet/interface/LjmetFactory.h"
 #include "FWLJMET/LJMet/interface/BaseEventSelector.h"
+#include "FWLJMET/LJMet/interface/LatencyProfiler.h"
+#include "FWLJMET/LJMet/interface/AllocationProfiler.h"
 
 
 //
@@ -83,6 +86,20 @@ class LJMet : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
       // choose event selector
       BaseEventSelector * theSelector = 0;
 
+      // wall-clock timing of selector stages and calculators, written to the Timing directory at endJob
+      bool profileTiming;
+      LatencyProfiler profiler;
+      unsigned int selectorTimer;
+      unsigned int calculatorsTimer;
+      unsigned int fillTimer;
+
+      // heap accounting of the same steps, written to the Allocations directory at endJob
+      bool profileAllocations;
+      std::unique_ptr<AllocationProfiler> allocProfiler;
+      unsigned int selectorAllocProbe = 0;
+      unsigned int calculatorsAllocProbe = 0;
+      unsigned int fillAllocProbe = 0;
+
 
       bool debug;
       int verbosity;
@@ -113,6 +130,8 @@ LJMet::LJMet(const edm::ParameterSet& iConfig)
    selection  = iConfig.getParameter<std::string>("selector");
    vExcl      = iConfig.getParameter<std::vector<std::string>>("exclude_calcs");
    vIncl      = iConfig.getParameter<std::vector<std::string>>("include_calcs");
+   profileTiming = iConfig.getUntrackedParameter<bool>("profileTiming", false);
+   profileAllocations = iConfig.getUntrackedParameter<bool>("profileAllocations", false);
 
 
    usesResource("TFileService"); // came originally with EDAnalyzer
@@ -126,6 +145,7 @@ LJMet::LJMet(const edm::ParameterSet& iConfig)
 
    // internal LJMet event content
    ec.SetVerbosity(verbosity);
+   ec.SetOutputTuning(iConfig.getUntrackedParameter<edm::ParameterSet>("treeOutput", edm::ParameterSet()));
    ec.SetTree(_tree);
 
    // The factory for event selector and calculator plugins
@@ -139,6 +159,30 @@ LJMet::LJMet(const edm::ParameterSet& iConfig)
    theSelector->SetEventContent(&ec);
    theSelector->Init();
 
+   if (profileTiming) {
+      std::cout << "[FWLJMet] : " << "timing selector stages and calculators" << std::endl;
+      theSelector->SetProfiler(&profiler);
+      factory->SetProfiler(&profiler);
+      selectorTimer    = profiler.Register("LJMet", "Selector");
+      calculatorsTimer = profiler.Register("LJMet", "Calculators");
+      if (ec.IsAsync()) {
+         // Fill only queues the event, TTree::Fill is timed on the writer thread
+         fillTimer = profiler.Register("LJMet", "Fill (queue)");
+         ec.SetWriteTimer(&profiler, profiler.Register("LJMet", "TTree::Fill (writer thread)"));
+      }
+      else fillTimer = profiler.Register("LJMet", "Fill");
+   }
+
+   if (profileAllocations) {
+      std::cout << "[FWLJMet] : " << "accounting heap use of selector stages and calculators" << std::endl;
+      allocProfiler.reset(new AllocationProfiler());
+      theSelector->SetAllocationProfiler(allocProfiler.get());
+      factory->SetAllocationProfiler(allocProfiler.get());
+      selectorAllocProbe    = allocProfiler->Register("LJMet", "Selector");
+      calculatorsAllocProbe = allocProfiler->Register("LJMet", "Calculators");
+      fillAllocProbe        = allocProfiler->Register("LJMet", ec.IsAsync() ? "Fill (queue)" : "Fill"); // the writer thread is not accounted
+   }
+
    //Object to pass to eventSelector and Calculators access data - https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuideEDMGetDataFromEvent#Consumes_and_Helpers
    edm::ConsumesCollector && cC = consumesCollector(); 
 
@@ -169,6 +213,19 @@ LJMet::LJMet(const edm::ParameterSet& iConfig)
             std::cout << "[FWLJMet] : "
             << "Creating histograms : " << iMod->first << "/"
             << iHist->second.GetName() << std::endl;
+            if (iHist->second.Is2D()){
+                iHist->second.SetHist( _dir.make<TH2F>(iHist->second.GetName().c_str(),
+                                                       iHist->second.GetName().c_str(),
+                                                       iHist->second.GetNBins(),
+                                                       iHist->second.GetXMin(),
+                                                       iHist->second.GetXMax(),
+                                                       iHist->second.GetNBinsY(),
+                                                       iHist->second.GetYMin(),
+                                                       iHist->second.GetYMax()
+                                                       )
+                                      );
+                continue;
+            }
             iHist->second.SetHist( _dir.make<TH1F>(iHist->second.GetName().c_str(),
                                                    iHist->second.GetName().c_str(),
                                                    iHist->second.GetNBins(),
@@ -218,7 +275,14 @@ LJMet::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 
 	// event selection
 	pat::strbitset ret = theSelector->getBitTemplate();
-	bool passed = (*theSelector)( iEvent, ret );
+	LatencyProfiler::Clock::time_point start;
+	if (profileTiming) start = LatencyProfiler::Now();
+	bool passed;
+	{
+		AllocationProfiler::Scope allocScope(allocProfiler.get(), selectorAllocProbe);
+		passed = (*theSelector)( iEvent, ret );
+	}
+	if (profileTiming) profiler.Stop(selectorTimer, start);
 
 
 	if ( passed ) {
@@ -226,7 +290,12 @@ LJMet::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 		//
 		//_____ Run all variable calculators now ___________________
 		//
-		factory->RunAllCalculators(iEvent, theSelector, ec, vIncl);
+		if (profileTiming) start = LatencyProfiler::Now();
+		{
+			AllocationProfiler::Scope allocScope(allocProfiler.get(), calculatorsAllocProbe);
+			factory->RunAllCalculators(iEvent, theSelector, ec, vIncl);
+		}
+		if (profileTiming) profiler.Stop(calculatorsTimer, start);
 
 
 		//
@@ -244,7 +313,12 @@ LJMet::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 		//
 		//_____Fill output file ____________________________________
 		//
-		ec.Fill();
+		if (profileTiming) start = LatencyProfiler::Now();
+		{
+			AllocationProfiler::Scope allocScope(allocProfiler.get(), fillAllocProbe);
+			ec.Fill();
+		}
+		if (profileTiming) profiler.Stop(fillTimer, start);
 
 	} // end if statement for final cut requirements
 
@@ -274,6 +348,28 @@ LJMet::endJob()
     // EndJob() for the selector
     theSelector->EndJob();
 
+    // per-thread histogram fills into the TFileService histograms
+    ec.MergeHists();
+
+    // events still queued for the writer thread
+    ec.FinishTree();
+    ec.PrintOutputReport(std::cout);
+
+
+    if (profileTiming) {
+        profiler.Print(std::cout);
+        edm::Service<TFileService> fs;
+        TFileDirectory timingDir = fs->mkdir("Timing");
+        profiler.Write(timingDir);
+    }
+
+    if (profileAllocations) {
+        allocProfiler->Print(std::cout);
+        edm::Service<TFileService> fs;
+        TFileDirectory allocDir = fs->mkdir("Allocations");
+        allocProfiler->Write(allocDir);
+    }
+
 }
 
 // ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
@@ -0,0 +1,386 @@
+// -*- C++ -*-
+//
+// Package:    FWLJMET/LJMet
+// Class:      LJMetBenchmark
+//
+/**\class LJMetBenchmark LJMetBenchmark.cc FWLJMET/LJMet/plugins/LJMetBenchmark.cc
+
+ Description: [Micro-benchmarks of the LJMet kernels]
+
+ Implementation:
+     [Runs each kernel nRepeat times back-to-back on the objects of locally cached events,
+      or on seeded synthetic input where no event content is needed, and reports ns per call
+      and calls per second at endJob. Configured with the jet/b-tag parameters of the LJMet selector,
+      see runLJMetBenchmark.py]
+*/
+
+
+// system include files
+#include <memory>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "FWCore/ServiceRegistry/interface/Service.h"
+#include "CommonTools/UtilAlgos/interface/TFileService.h"
+
+#include "DataFormats/PatCandidates/interface/Jet.h"
+#include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/PatCandidates/interface/Electron.h"
+#include "DataFormats/PatCandidates/interface/PackedCandidate.h"
+
+#include "FWLJMET/LJMet/interface/LjmetEventContent.h"
+#include "FWLJMET/LJMet/interface/LjmetFactory.h"
+#include "FWLJMET/LJMet/interface/LatencyProfiler.h"
+#include "FWLJMET/LJMet/interface/MiniIsolation.h"
+#include "FWLJMET/LJMet/interface/JetMETCorrHelper.h"
+#include "FWLJMET/LJMet/interface/BTagSFUtil.h"
+#include "FWLJMET/LJMet/interface/BtagHardcodedConditions.h"
+#include "FWLJMET/LJMet/interface/AK8FeatureCache.h"
+#include "FWLJMET/LJMet/interface/BestCalc.h"
+
+#include "TTree.h"
+#include "TRandom3.h"
+
+
+class LJMetBenchmark : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
+   public:
+      explicit LJMetBenchmark(const edm::ParameterSet&);
+      ~LJMetBenchmark();
+
+      static void fillDescriptions(edm::ConfigurationDescriptions& descriptions);
+
+
+   private:
+      virtual void beginJob() override;
+      virtual void analyze(const edm::Event&, const edm::EventSetup&) override;
+      virtual void endJob() override;
+
+      void benchMiniIsolation(const edm::Event&);
+      void benchJets(const edm::Event&);
+      void benchBtagConditions();
+      void benchEventContent(const edm::Event&);
+      void benchBest(const edm::Event&);
+
+      // ----------member data ---------------------------
+
+      std::string mLegend = "\t[LJMetBenchmark]: ";
+
+      bool debug;
+      unsigned int nRepeat;      // back-to-back calls per object
+      unsigned int nLookups;     // synthetic (pt, eta) points per event for the b-tag tables
+      unsigned int nTreeEntries; // entries kept in the in-memory tree before it is reset
+
+      // kernels, set up from the selector PSet exactly as the selector does
+      bool isMc;
+      bool doNewJEC;
+      unsigned int syst;
+      std::string btagOP;
+      JetMETCorrHelper JetMETCorr;
+      BTagSFUtil btagSfUtil;
+      BtagHardcodedConditions btagConditions;
+      AK8FeatureCache ak8Features;
+      BestCalc * best = 0;
+
+      edm::EDGetTokenT<pat::JetCollection>           jetsToken;
+      edm::EDGetTokenT<pat::JetCollection>           AK8jetsToken;
+      edm::EDGetTokenT<pat::MuonCollection>          muonsToken;
+      edm::EDGetTokenT<pat::ElectronCollection>      electronsToken;
+      edm::EDGetTokenT<pat::PackedCandidateCollection> PFCandToken;
+      edm::EDGetTokenT<double>                       rhoJetsToken;
+      edm::EDGetTokenT<double>                       rhoJetsNC_Token;
+
+      // fixed-seed synthetic input
+      TRandom3 rand;
+      std::vector<double> vLookupPt;
+      std::vector<double> vLookupEta;
+
+      // event content filled into a tree that is never written
+      TTree * tree = 0;
+      LjmetEventContent ec;
+
+      LatencyProfiler profiler;
+      unsigned int miniIsoEATimer;
+      unsigned int miniIsoDBTimer;
+      unsigned int correctJetTimer;
+      unsigned int correctJetAK8Timer;
+      unsigned int isJetTaggedTimer;
+      unsigned int btagEffTimer;
+      unsigned int mistagRateTimer;
+      unsigned int setValueTimer;
+      unsigned int fillTimer;
+      unsigned int bestTimer;
+
+};
+
+
+LJMetBenchmark::LJMetBenchmark(const edm::ParameterSet& iConfig)
+{
+   debug        = iConfig.getParameter<bool>("debug");
+   nRepeat      = iConfig.getUntrackedParameter<unsigned int>("nRepeat", 100);
+   nLookups     = iConfig.getUntrackedParameter<unsigned int>("nLookups", 1000);
+   nTreeEntries = iConfig.getUntrackedParameter<unsigned int>("nTreeEntries", 1000);
+   unsigned int seed = iConfig.getUntrackedParameter<unsigned int>("seed", 12345);
+
+   std::string selection = iConfig.getParameter<std::string>("selector");
+   const edm::ParameterSet& selectorConfig = iConfig.getParameterSet(selection);
+
+   usesResource("TFileService");
+
+   edm::ConsumesCollector && cC = consumesCollector();
+
+   isMc     = selectorConfig.getParameter<bool>("isMc");
+   doNewJEC = selectorConfig.getParameter<bool>("doNewJEC");
+   btagOP   = selectorConfig.getParameter<std::string>("btagOP");
+   if (selectorConfig.getParameter<bool>("JECup")) syst = 1;
+   else if (selectorConfig.getParameter<bool>("JECdown")) syst = 2;
+   else if (selectorConfig.getParameter<bool>("JERup")) syst = 3;
+   else if (selectorConfig.getParameter<bool>("JERdown")) syst = 4;
+   else syst = 0; //nominal
+
+   jetsToken       = cC.consumes<pat::JetCollection>(selectorConfig.getParameter<edm::InputTag>("jet_collection"));
+   AK8jetsToken    = cC.consumes<pat::JetCollection>(selectorConfig.getParameter<edm::InputTag>("AK8jet_collection"));
+   muonsToken      = cC.consumes<pat::MuonCollection>(selectorConfig.getParameter<edm::InputTag>("muonsCollection"));
+   electronsToken  = cC.consumes<pat::ElectronCollection>(selectorConfig.getParameter<edm::InputTag>("electronsCollection"));
+   PFCandToken     = cC.consumes<pat::PackedCandidateCollection>(selectorConfig.getParameter<edm::InputTag>("PFparticlesCollection"));
+   rhoJetsToken    = cC.consumes<double>(selectorConfig.getParameter<edm::InputTag>("rhoJetsInputTag"));
+   rhoJetsNC_Token = cC.consumes<double>(selectorConfig.getParameter<edm::InputTag>("rhoJetsNCInputTag"));
+
+   JetMETCorr.Initialize(selectorConfig);
+   btagSfUtil.Initialize(selectorConfig);
+   ak8Features.Initialize(&JetMETCorr, &btagSfUtil, rhoJetsToken, doNewJEC, syst, isMc);
+
+   // BestCalc is only benchmarked when its PSet is given
+   if (iConfig.existsAs<edm::ParameterSet>("BestCalc")) {
+      LjmetFactory * factory = LjmetFactory::GetInstance();
+      std::vector<std::string> vBest(1, "BestCalc");
+      factory->SetAllCalcConfig(iConfig, vBest);
+      factory->BeginJobAllCalc((edm::ConsumesCollector &&)cC, vBest);
+      best = dynamic_cast<BestCalc *>(factory->GetCalculator("BestCalc"));
+   }
+
+   // synthetic b-tag table lookups, same points every job
+   rand.SetSeed(seed);
+   for (unsigned int i = 0; i < nLookups; i++){
+      vLookupPt.push_back(20. + rand.Exp(80.));
+      vLookupEta.push_back(rand.Uniform(0., 2.4));
+   }
+
+   // the tree stays in memory: this measures the branch filling, not the file I/O
+   tree = new TTree("ljmetBenchmark", "ljmetBenchmark");
+   tree->SetDirectory(0);
+   ec.SetVerbosity(0);
+   ec.SetTree(tree);
+
+   miniIsoEATimer     = profiler.Register("Kernels", "getPFMiniIsolation_EffectiveArea");
+   miniIsoDBTimer     = profiler.Register("Kernels", "getPFMiniIsolation_DeltaBeta");
+   correctJetTimer    = profiler.Register("Kernels", "correctJetReturnPatJet");
+   correctJetAK8Timer = profiler.Register("Kernels", "correctJetReturnPatJet_AK8");
+   isJetTaggedTimer   = profiler.Register("Kernels", "isJetTagged");
+   btagEffTimer       = profiler.Register("Kernels", "GetBtagEfficiency");
+   mistagRateTimer    = profiler.Register("Kernels", "GetMistagRate");
+   setValueTimer      = profiler.Register("Kernels", "LjmetEventContent_SetValue");
+   fillTimer          = profiler.Register("Kernels", "LjmetEventContent_Fill");
+   if (best) bestTimer = profiler.Register("Kernels", "BestCalc_execute");
+
+   std::cout << mLegend << nRepeat << " calls per object, " << nLookups << " b-tag lookups per event, seed " << seed << std::endl;
+}
+
+
+LJMetBenchmark::~LJMetBenchmark()
+{
+    delete tree;
+}
+
+
+void
+LJMetBenchmark::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
+{
+    if(debug) std::cout << mLegend << "event " << iEvent.id() << std::endl;
+
+    if(!isMc) JetMETCorr.SetFacJetCorr(iEvent);
+
+    benchMiniIsolation(iEvent);
+    benchJets(iEvent);
+    benchBtagConditions();
+    benchEventContent(iEvent);
+    if (best) benchBest(iEvent);
+}
+
+
+void LJMetBenchmark::benchMiniIsolation(const edm::Event& iEvent)
+{
+    edm::Handle<pat::PackedCandidateCollection> packedPFCands;
+    iEvent.getByToken(PFCandToken, packedPFCands);
+    edm::Handle<double> rhoJetsNC;
+    iEvent.getByToken(rhoJetsNC_Token, rhoJetsNC);
+    edm::Handle<pat::MuonCollection> muonsHandle;
+    iEvent.getByToken(muonsToken, muonsHandle);
+    edm::Handle<pat::ElectronCollection> electronsHandle;
+    iEvent.getByToken(electronsToken, electronsHandle);
+
+    // same cone parameters as MultiLepCalc
+    std::vector<const reco::Candidate *> vLeptons;
+    for (auto const & mu : *muonsHandle) vLeptons.push_back(&mu);
+    for (auto const & el : *electronsHandle) vLeptons.push_back(&el);
+
+    double sum = 0;
+    for (auto const * lep : vLeptons){
+        LatencyProfiler::Clock::time_point start = LatencyProfiler::Now();
+        for (unsigned int i = 0; i < nRepeat; i++) sum += getPFMiniIsolation_EffectiveArea(packedPFCands, lep, 0.05, 0.2, 10., false, false, *rhoJetsNC);
+        profiler.Stop(miniIsoEATimer, start, nRepeat);
+
+        start = LatencyProfiler::Now();
+        for (unsigned int i = 0; i < nRepeat; i++) sum += getPFMiniIsolation_DeltaBeta(packedPFCands, lep, 0.05, 0.2, 10., false);
+        profiler.Stop(miniIsoDBTimer, start, nRepeat);
+    }
+    if(debug) std::cout << mLegend << "mini-isolation sum " << sum << std::endl;
+}
+
+
+void LJMetBenchmark::benchJets(const edm::Event& iEvent)
+{
+    edm::Handle<pat::JetCollection> jetsHandle;
+    iEvent.getByToken(jetsToken, jetsHandle);
+    edm::Handle<pat::JetCollection> AK8jetsHandle;
+    iEvent.getByToken(AK8jetsToken, AK8jetsHandle);
+
+    double sum = 0;
+    for (auto const & jet : *jetsHandle){
+        LatencyProfiler::Clock::time_point start = LatencyProfiler::Now();
+        for (unsigned int i = 0; i < nRepeat; i++) sum += JetMETCorr.correctJetReturnPatJet(jet, iEvent, rhoJetsToken, false, doNewJEC, syst).pt();
+        profiler.Stop(correctJetTimer, start, nRepeat);
+
+        pat::Jet corrJet = JetMETCorr.correctJetReturnPatJet(jet, iEvent, rhoJetsToken, false, doNewJEC, syst);
+        TLorentzVector jetP4;
+        jetP4.SetPtEtaPhiE(corrJet.pt(), corrJet.eta(), corrJet.phi(), corrJet.energy());
+
+        start = LatencyProfiler::Now();
+        for (unsigned int i = 0; i < nRepeat; i++) sum += btagSfUtil.isJetTagged(corrJet, jetP4, iEvent, isMc);
+        profiler.Stop(isJetTaggedTimer, start, nRepeat);
+    }
+
+    for (auto const & jet : *AK8jetsHandle){
+        LatencyProfiler::Clock::time_point start = LatencyProfiler::Now();
+        for (unsigned int i = 0; i < nRepeat; i++) sum += JetMETCorr.correctJetReturnPatJet(jet, iEvent, rhoJetsToken, true, doNewJEC, syst).pt();
+        profiler.Stop(correctJetAK8Timer, start, nRepeat);
+    }
+    if(debug) std::cout << mLegend << "jet sum " << sum << std::endl;
+}
+
+
+void LJMetBenchmark::benchBtagConditions()
+{
+    std::string const tagger = "DeepCSV"+btagOP;
+
+    double sum = 0;
+    LatencyProfiler::Clock::time_point start = LatencyProfiler::Now();
+    for (unsigned int i = 0; i < nLookups; i++) sum += btagConditions.GetBtagEfficiency(vLookupPt[i], vLookupEta[i], tagger);
+    profiler.Stop(btagEffTimer, start, nLookups);
+
+    start = LatencyProfiler::Now();
+    for (unsigned int i = 0; i < nLookups; i++) sum += btagConditions.GetMistagRate(vLookupPt[i], vLookupEta[i], tagger);
+    profiler.Stop(mistagRateTimer, start, nLookups);
+
+    if(debug) std::cout << mLegend << "b-tag lookup sum " << sum << std::endl;
+}
+
+
+void LJMetBenchmark::benchEventContent(const edm::Event& iEvent)
+{
+    edm::Handle<pat::JetCollection> jetsHandle;
+    iEvent.getByToken(jetsToken, jetsHandle);
+
+    std::vector<double> vPt, vEta, vPhi, vEnergy;
+    std::vector<int> vFlavour;
+    for (auto const & jet : *jetsHandle){
+        vPt.push_back(jet.pt());
+        vEta.push_back(jet.eta());
+        vPhi.push_back(jet.phi());
+        vEnergy.push_back(jet.energy());
+        vFlavour.push_back(jet.hadronFlavour());
+    }
+
+    // a typical calculator payload: a few scalars and per-jet vectors
+    LatencyProfiler::Clock::time_point start = LatencyProfiler::Now();
+    ec.SetValue("run", (int)iEvent.id().run());
+    ec.SetValue("event", (long long)iEvent.id().event());
+    ec.SetValue("NJets", (int)vPt.size());
+    ec.SetValue("HT", std::accumulate(vPt.begin(), vPt.end(), 0.));
+    ec.SetValue("passed", !vPt.empty());
+    ec.SetValue("jetPt", vPt);
+    ec.SetValue("jetEta", vEta);
+    ec.SetValue("jetPhi", vPhi);
+    ec.SetValue("jetEnergy", vEnergy);
+    ec.SetValue("jetHadronFlavour", vFlavour);
+    profiler.Stop(setValueTimer, start, 10);
+
+    start = LatencyProfiler::Now();
+    ec.Fill();
+    profiler.Stop(fillTimer, start);
+
+    if (tree->GetEntries() >= (Long64_t)nTreeEntries) tree->Reset();
+}
+
+
+void LJMetBenchmark::benchBest(const edm::Event& iEvent)
+{
+    edm::Handle<pat::JetCollection> AK8jetsHandle;
+    iEvent.getByToken(AK8jetsToken, AK8jetsHandle);
+
+    // same inputs as BestCalc sees in LJMet: corrected AK8 jets and their cached substructure
+    std::vector<pat::Jet> vCorrJets_AK8;
+    for (auto const & jet : *AK8jetsHandle){
+        vCorrJets_AK8.push_back(JetMETCorr.correctJetReturnPatJet(jet, iEvent, rhoJetsToken, true, doNewJEC, syst));
+    }
+    ak8Features.Reset(iEvent, vCorrJets_AK8);
+
+    double sum = 0;
+    for (unsigned int ijet = 0; ijet < vCorrJets_AK8.size(); ijet++){
+        if (vCorrJets_AK8[ijet].pt() < 170) continue; // as in BestCalc::AnalyzeEvent
+        AK8FeatureCache::JetFeatures const & features = ak8Features.Get(ijet);
+
+        LatencyProfiler::Clock::time_point start = LatencyProfiler::Now();
+        for (unsigned int i = 0; i < nRepeat; i++) sum += best->execute(vCorrJets_AK8[ijet], features).size();
+        profiler.Stop(bestTimer, start, nRepeat);
+    }
+    if(debug) std::cout << mLegend << "BEST sum " << sum << std::endl;
+}
+
+
+void
+LJMetBenchmark::beginJob()
+{
+}
+
+
+void
+LJMetBenchmark::endJob()
+{
+    profiler.Print(std::cout);
+    JetMETCorr.PrintWarnings(std::cout);
+
+    edm::Service<TFileService> fs;
+    TFileDirectory benchDir = fs->mkdir("Benchmark");
+    profiler.Write(benchDir);
+}
+
+
+void
+LJMetBenchmark::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
+  edm::ParameterSetDescription desc;
+  desc.setUnknown();
+  descriptions.addDefault(desc);
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(LJMetBenchmark);
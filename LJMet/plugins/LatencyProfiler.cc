@@ -0,0 +1,91 @@
+#include "FWLJMET/LJMet/interface/LatencyProfiler.h"
+
+#include <cmath>
+#include <iomanip>
+#include <map>
+
+#include "TH1F.h"
+
+
+const int LatencyProfiler::nBins;
+constexpr double LatencyProfiler::xMin;
+constexpr double LatencyProfiler::xMax;
+
+
+LatencyProfiler::LatencyProfiler():
+    mLegend("\t[LatencyProfiler]: ")
+{
+}
+
+
+unsigned int LatencyProfiler::Register(std::string const & group, std::string const & name)
+{
+    for (unsigned int i = 0; i < mvTimers.size(); i++){
+        if (mvTimers[i].group == group && mvTimers[i].name == name) return i;
+    }
+
+    Timer timer;
+    timer.group   = group;
+    timer.name    = name;
+    timer.nCalls  = 0;
+    timer.totalNs = 0;
+    timer.counts.assign(nBins+2, 0);
+    mvTimers.push_back(timer);
+
+    return mvTimers.size()-1;
+}
+
+
+void LatencyProfiler::add(unsigned int id, long long ns, unsigned long long nCalls)
+{
+    if (nCalls == 0) return;
+
+    Timer & timer = mvTimers[id];
+    timer.nCalls  += nCalls;
+    timer.totalNs += ns;
+
+    int bin = 0; // underflow, also for 0 ns
+    if (ns > 0){
+        double x = std::log10((double)ns/nCalls);
+        if (x >= xMax) bin = nBins+1;
+        else if (x >= xMin) bin = 1 + (int)((x-xMin)/(xMax-xMin)*nBins);
+    }
+    timer.counts[bin] += nCalls;
+}
+
+
+void LatencyProfiler::Write(TFileDirectory & dir) const
+{
+    std::map<std::string, TFileDirectory> groupDirs;
+
+    for (auto const & timer : mvTimers){
+        if (groupDirs.find(timer.group) == groupDirs.end()) groupDirs.insert(std::make_pair(timer.group, dir.mkdir(timer.group)));
+
+        // histogram names cannot hold spaces or slashes
+        std::string histName = timer.name;
+        for (auto & c : histName) if (c == ' ' || c == '/') c = '_';
+
+        TH1F * h = groupDirs.find(timer.group)->second.make<TH1F>(histName.c_str(),
+                                                                  (timer.name+";log_{10}(latency/ns);calls").c_str(),
+                                                                  nBins, xMin, xMax);
+        for (int bin = 0; bin <= nBins+1; bin++) h->SetBinContent(bin, timer.counts[bin]);
+        h->SetEntries(timer.nCalls);
+    }
+}
+
+
+void LatencyProfiler::Print(std::ostream & out) const
+{
+    out << mLegend << "Wall-clock time per call (calls / mean us / total s / calls per s):" << std::endl;
+    for (auto const & timer : mvTimers){
+        double mean = timer.nCalls > 0 ? timer.totalNs/timer.nCalls : 0;
+        double rate = timer.totalNs > 0 ? timer.nCalls/(timer.totalNs*1e-9) : 0;
+        out << mLegend << "  " << std::left << std::setw(40) << (timer.group+"/"+timer.name) << std::right
+            << std::setw(12) << timer.nCalls
+            << std::setw(12) << std::fixed << std::setprecision(3) << mean*1e-3
+            << std::setw(12) << std::setprecision(3) << timer.totalNs*1e-9
+            << std::setw(14) << std::setprecision(0) << rate << std::endl;
+    }
+    out.unsetf(std::ios::floatfield);
+    out.precision(6);
+}
@@ -1,11 +1,17 @@
 #include "FWLJMET/LJMet/interface/LjmetEventContent.h"
+#include "FWLJMET/LJMet/interface/LatencyProfiler.h"
+
+#include <algorithm>
+#include <chrono>
 
 LjmetEventContent::LjmetEventContent():
 mName("LjmetEventContent"),
 mLegend("[LjmetEventContent]: "),
 mpTree(0),
 mFirstEntry(true),
-mVerbosity(0)
+mVerbosity(0),
+mpWriteProfiler(0),
+mWriteTimer(0)
 {
 }
 
@@ -14,13 +20,17 @@ mName("LjmetEventContent"),
 mLegend("[LjmetEventContent]: "),
 mpTree(0),
 mFirstEntry(true),
-mVerbosity(0)
+mVerbosity(0),
+mpWriteProfiler(0),
+mWriteTimer(0)
 {
 	mVerbosity = iConfig.getParameter<int>("verbosity");
 }
 
 LjmetEventContent::~LjmetEventContent()
 {
+    // joins the writer thread if FinishTree was not called
+    mpWriter.reset();
 }
 
 void LjmetEventContent::SetVerbosity(int verbosity)
@@ -28,39 +38,63 @@ void LjmetEventContent::SetVerbosity(int verbosity)
     mVerbosity = verbosity;
 }
 
+void LjmetEventContent::SetOutputTuning(edm::ParameterSet const & pset)
+{
+    mTuning.Configure(pset);
+    mPrecision.Configure(pset.getUntrackedParameter<std::vector<edm::ParameterSet>>("precision", std::vector<edm::ParameterSet>()));
+
+    unsigned int depth = pset.getUntrackedParameter<unsigned int>("asyncQueueDepth", 0);
+    if (depth > 0) {
+        std::cout << mLegend << "TTree::Fill on a writer thread, up to " << depth << " events in flight" << std::endl;
+        mpWriter.reset(new AsyncTreeWriter(depth, [this]{ fillTree(); }));
+    }
+}
+
 void LjmetEventContent::SetTree(TTree * tree)
 {
     mpTree = tree;
+    mTuning.ApplyToTree(mpTree);
 }
 
-void LjmetEventContent::SetHistogram(std::string modname, std::string histname, int nbins, double low, double high)
+LjmetEventContent::HistHandle LjmetEventContent::SetHistogram(std::string modname, std::string histname, int nbins, double low, double high)
 {
     // Create histogram entry in event content, so it is created by the LjmetFactory
-    mLegend = "[" + mName + "]: " ;
-    
+    return book(modname, histname, HistMetadata(histname, nbins, low, high));
+}
+
+LjmetEventContent::HistHandle LjmetEventContent::SetHistogram2D(std::string modname, std::string histname,
+                                                                int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh)
+{
+    return book(modname, histname, HistMetadata(histname, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh));
+}
+
+LjmetEventContent::HistHandle LjmetEventContent::book(std::string const & modname, std::string const & histname, HistMetadata const & hist)
+{
     //mDoubleHist[modname][histname]
-    
-    std::map<std::string, std::map<std::string, HistMetadata>>::iterator iMod;
-    std::map<std::string, HistMetadata>::iterator iHist;
-    
-    iMod = mDoubleHist.lower_bound(modname);
-    
-    if (iMod != mDoubleHist.end() && !(mDoubleHist.key_comp()(modname, iMod->first))) {
-        // Key already exists. Update iMod->second
-        iHist = iMod->second.lower_bound(histname);
-        if(iHist != iMod->second.end() && !(iMod->second.key_comp()(histname, iHist->first))) {
-            // Key already exists. Update iHist->second - not needed
-            std::cout << mLegend << "Histogram " << modname << "/" << histname << " is already set" << std::endl;
-        } else {
-            // The key does not exist in the map. Add it.
-            iMod->second.insert(iHist, std::pair<std::string, HistMetadata>(histname, HistMetadata(histname, nbins, low, high)));
-        }
-    } else {
-        // The key does not exist in the map. Add it.
-        std::map<std::string,HistMetadata> _map;
-        _map.insert(std::pair<std::string, HistMetadata>(histname, HistMetadata(histname, nbins, low, high)));
-        mDoubleHist.insert(iMod, std::pair<std::string, std::map<std::string, HistMetadata>>(modname, _map));
-        // Use iMod as a hint to insert, so it can avoid another lookup
+    std::map<std::string, HistMetadata> & modHists = mDoubleHist[modname];
+    std::map<std::string, HistMetadata>::iterator iHist = modHists.lower_bound(histname);
+
+    if(iHist != modHists.end() && !(modHists.key_comp()(histname, iHist->first))) {
+        // Key already exists, hand out the handle it got when booked
+        std::cout << mLegend << "Histogram " << modname << "/" << histname << " is already set" << std::endl;
+        return iHist->second.GetHandle();
+    }
+
+    // The key does not exist in the map. Add it.
+    iHist = modHists.insert(iHist, std::pair<std::string, HistMetadata>(histname, hist));
+    mvHist.push_back(&iHist->second);
+
+    HistMetadata & meta = iHist->second;
+    meta.SetHandle(mHists.Book(meta.GetNBins(), meta.GetXMin(), meta.GetXMax(), meta.GetNBinsY(), meta.GetYMin(), meta.GetYMax()));
+    return meta.GetHandle();
+}
+
+void LjmetEventContent::MergeHists()
+{
+    for (unsigned int i = 0; i < mvHist.size(); ++i){
+        TH1 * _hist = mvHist[i]->GetHist();
+        if (_hist) mHists.Merge(i, _hist);
+        else std::cout << mLegend << "Histo " << mvHist[i]->GetName() << " is NULL" << std::endl;
     }
 }
 
@@ -85,23 +119,23 @@ void LjmetEventContent::SetValue(std::string key, double value)
     mDoubleBranch[key] = value;
 }
 
-void LjmetEventContent::SetValue(std::string key, std::vector<bool> value)
+void LjmetEventContent::SetValue(std::string key, std::vector<bool> const & value)
 {
     mVectorBoolBranch[key] = value;
 }
 
-void LjmetEventContent::SetValue(std::string key, std::vector<int> value)
+void LjmetEventContent::SetValue(std::string key, std::vector<int> const & value)
 {
     mVectorIntBranch[key] = value;
 }
 
-void LjmetEventContent::SetValue(std::string key, std::vector<double> value)
+void LjmetEventContent::SetValue(std::string key, std::vector<double> const & value)
 {
     mVectorDoubleBranch[key] = value;
 }
 
 
-void LjmetEventContent::SetValue(std::string key,std::vector<std::string> value){
+void LjmetEventContent::SetValue(std::string key,std::vector<std::string> const & value){
     mVectorStringBranch[key] = value;
 }
 
@@ -110,8 +144,6 @@ void LjmetEventContent::SetHistValue(std::string modname, std::string histname,
 {
     // Assign current hist value to hist metadata collection
     
-    mLegend = "[" + mName + "]: ";
-    
     std::map<std::string, std::map<std::string, HistMetadata>>::iterator iMod;
     std::map<std::string, HistMetadata>::iterator iHist;
     
@@ -123,6 +155,8 @@ void LjmetEventContent::SetHistValue(std::string modname, std::string histname,
         if(iHist != iMod->second.end() && !(iMod->second.key_comp()(histname, iHist->first))) {
             // Key already exists. Update iHist->second - not needed
             iHist->second.SetValue(value);
+            HistHandle hist = iHist->second.GetHandle();
+            if (std::find(mvHistValueSet.begin(), mvHistValueSet.end(), hist) == mvHistValueSet.end()) mvHistValueSet.push_back(hist);
         } else {
             // The key does not exist in the map. Add it.
             std::cout << mLegend << "Cannot set value, histogram " << histname << " in module " << modname << " does not exist" << std::endl;
@@ -133,38 +167,22 @@ void LjmetEventContent::SetHistValue(std::string modname, std::string histname,
     }
 }
 
-void LjmetEventContent::FillHist(std::string modname, std::string histname, double value)
+void LjmetEventContent::FillHist(std::string modname, std::string histname, double value, double weight)
 {
+    std::map<std::string, std::map<std::string, HistMetadata>>::iterator iMod = mDoubleHist.find(modname);
+    if (iMod == mDoubleHist.end()){
+        std::cout << mLegend << "[" << modname << "]:" << "Problem finding map of map of histo for this module" << std::endl;
+        return;
+    }
 
-    // fill histograms NOTE: THIS CAN BE IMROVED! NO NEED TO LOOP, JUST DIRECTLY FIND VALUE BY KEY! (For some reason it was not working at first try. But try again!)
-    std::map<std::string, std::map<std::string, LjmetEventContent::HistMetadata>>::iterator iMod;
-    std::map<std::string, LjmetEventContent::HistMetadata>::iterator iHist;
-    for (iMod = mDoubleHist.begin(); iMod != mDoubleHist.end(); ++iMod) {
-    	if(iMod->first == modname){    			
-			for (iHist = iMod->second.begin(); iHist != iMod->second.end(); ++iHist) {
-    			if(iHist->first==histname){
-					TH1 * _hist = iHist->second.GetHist();
-					if (_hist){
-						_hist->Fill(value);
-						if(mVerbosity>1) std::cout << mLegend <<"["+modname+"]:"<<"Filling "+histname+" histogram" << std::endl;
-					}
-					else{
-						std::cout << mLegend <<"Histo "+histname+" is NULL" << std::endl;
-					}
-					break; // end loop when map of histo is found
-				}
-				else if (iHist == iMod->second.end()){
-					std::cout << mLegend <<"["+modname+"]:"<<"Problem finding map of of histo for this module" << std::endl;
-				}
-			}
-			break; //end loop when map of map of histo is found
-		}
-		else if(iMod == mDoubleHist.end()){
-			std::cout << mLegend <<"["+modname+"]:"<<"Problem finding map of map of histo for this module" << std::endl;		
-		}
-
+    std::map<std::string, HistMetadata>::iterator iHist = iMod->second.find(histname);
+    if (iHist == iMod->second.end()){
+        std::cout << mLegend << "[" << modname << "]:" << "Problem finding map of of histo for this module" << std::endl;
+        return;
     }
 
+    FillHist(iHist->second.GetHandle(), value, weight);
+    if(mVerbosity>1) std::cout << mLegend << "[" << modname << "]:" << "Filling " << histname << " histogram" << std::endl;
 }
 
 
@@ -174,19 +192,15 @@ void LjmetEventContent::Fill()
         createBranches();
         mFirstEntry = false;
     }
-    mpTree->Fill();
+    reducePrecision();
+
+    if (mpWriter) mpWriter->Push();
+    else fillTree();
     
-    // fill histograms --> Replaced by FillHist !! Now we fill each histogram one at a time individually, not all at once.
-    /*
-    std::map<std::string, std::map<std::string, LjmetEventContent::HistMetadata>>::iterator iMod;
-    std::map<std::string, LjmetEventContent::HistMetadata>::iterator iHist;
-    for (iMod = mDoubleHist.begin(); iMod != mDoubleHist.end(); ++iMod) {
-        for (iHist = iMod->second.begin(); iHist != iMod->second.end(); ++iHist) {
-            TH1 * _hist = iHist->second.GetHist();
-            if (_hist) _hist->Fill(iHist->second.GetValue());
-        }
-    }
-    */
+    // histograms given a value by SetHistValue in this event, once each with the last value;
+    // the others are filled one at a time by FillHist
+    for (HistHandle hist : mvHistValueSet) FillHist(hist, mvHist[hist]->GetValue());
+    mvHistValueSet.clear();
 }
 
 int LjmetEventContent::createBranches()
@@ -201,7 +215,8 @@ int LjmetEventContent::createBranches()
     // Boolean branches
     for (std::map<std::string, bool>::iterator br = mBoolBranch.begin(); br != mBoolBranch.end(); ++br) {
         name_type = br->first + "/O";
-        mpTree->Branch(br->first.c_str(), &(br->second), name_type.c_str());
+        mpTree->Branch(br->first.c_str(), branchAddress(br->second), name_type.c_str());
+        mTuning.AddBranch(mpTree, br->first, "bool");
         
         if (mVerbosity > 0) {
             std::cout << mLegend << "Branch " << name_type << " created" << std::endl;
@@ -212,7 +227,8 @@ int LjmetEventContent::createBranches()
     // Integer branches
     for (std::map<std::string, int>::iterator br = mIntBranch.begin(); br != mIntBranch.end(); ++br) {
         name_type = br->first + "/I";
-        mpTree->Branch(br->first.c_str(), &(br->second), name_type.c_str());
+        mpTree->Branch(br->first.c_str(), branchAddress(br->second), name_type.c_str());
+        mTuning.AddBranch(mpTree, br->first, "int");
         
         if (mVerbosity > 0) {
             std::cout << mLegend << "Branch " << name_type << " created" << std::endl;
@@ -224,7 +240,8 @@ int LjmetEventContent::createBranches()
     // Long Integer branches
     for (std::map<std::string, long long>::iterator br = mLongIntBranch.begin(); br != mLongIntBranch.end(); ++br) {
         name_type = br->first + "/L";
-        mpTree->Branch(br->first.c_str(), &(br->second), name_type.c_str());
+        mpTree->Branch(br->first.c_str(), branchAddress(br->second), name_type.c_str());
+        mTuning.AddBranch(mpTree, br->first, "long long");
         
         if (mVerbosity > 0) {
             std::cout << mLegend << "Branch " << name_type << " created" << std::endl;
@@ -235,8 +252,19 @@ int LjmetEventContent::createBranches()
 
     // Double branches
     for (std::map<std::string, double>::iterator br = mDoubleBranch.begin(); br != mDoubleBranch.end(); ++br) {
-        name_type = br->first + "/D";
-        mpTree->Branch(br->first.c_str(), &(br->second), name_type.c_str());
+        BranchPrecision::Rule const * rule = mPrecision.Match(br->first);
+        if (rule) {
+            float & target = mReducedDoubleBranch[br->first];
+            mvReducedBranch.push_back({&(br->second), &target, rule});
+            name_type = br->first + "/F";
+            mpTree->Branch(br->first.c_str(), branchAddress(target), name_type.c_str());
+            mTuning.AddBranch(mpTree, br->first, "double as float");
+        }
+        else {
+            name_type = br->first + "/D";
+            mpTree->Branch(br->first.c_str(), branchAddress(br->second), name_type.c_str());
+            mTuning.AddBranch(mpTree, br->first, "double");
+        }
         
         if (mVerbosity > 0) {
             std::cout << mLegend << "Branch " << name_type << " created" << std::endl;
@@ -246,7 +274,8 @@ int LjmetEventContent::createBranches()
     
     // Vector-of-bool branches
     for (std::map<std::string, std::vector<bool>>::iterator br = mVectorBoolBranch.begin(); br != mVectorBoolBranch.end(); ++br) {
-        mpTree->Branch(br->first.c_str(), &(br->second));
+        mpTree->Branch(br->first.c_str(), branchAddress(br->second));
+        mTuning.AddBranch(mpTree, br->first, "std::vector<bool>");
         
         if (mVerbosity > 0) {
             std::cout << mLegend << "Branch " << br->first << " std::vector<bool> created" << std::endl;
@@ -256,7 +285,8 @@ int LjmetEventContent::createBranches()
     
     // Vector-of-int branches
     for (std::map<std::string, std::vector<int>>::iterator br = mVectorIntBranch.begin(); br != mVectorIntBranch.end(); ++br) {
-        mpTree-> Branch(br->first.c_str(), &(br->second));
+        mpTree-> Branch(br->first.c_str(), branchAddress(br->second));
+        mTuning.AddBranch(mpTree, br->first, "std::vector<int>");
         
         if (mVerbosity > 0) {
             std::cout << mLegend << "Branch " << br->first << " std::vector<int> created" << std::endl;
@@ -266,7 +296,17 @@ int LjmetEventContent::createBranches()
     
     // Vector-of-double branches
     for (std::map<std::string, std::vector<double>>::iterator br = mVectorDoubleBranch.begin(); br != mVectorDoubleBranch.end(); ++br) {
-        mpTree->Branch(br->first.c_str(), &(br->second));
+        BranchPrecision::Rule const * rule = mPrecision.Match(br->first);
+        if (rule) {
+            std::vector<float> & target = mReducedVectorDoubleBranch[br->first];
+            mvReducedVectorBranch.push_back({&(br->second), &target, rule});
+            mpTree->Branch(br->first.c_str(), branchAddress(target));
+            mTuning.AddBranch(mpTree, br->first, "std::vector<double> as float");
+        }
+        else {
+            mpTree->Branch(br->first.c_str(), branchAddress(br->second));
+            mTuning.AddBranch(mpTree, br->first, "std::vector<double>");
+        }
         
         if (mVerbosity > 0) {
             std::cout << mLegend << "Branch " << br->first << " std::vector<double> created" << std::endl;
@@ -283,7 +323,8 @@ int LjmetEventContent::createBranches()
         std::string name_type = br->first+" std::vector<std::string>";
       //      std::string type = "VVString";
       mpTree -> Branch(br->first.c_str(),
-		       &(br->second));
+		       branchAddress(br->second));
+        mTuning.AddBranch(mpTree, br->first, "std::vector<std::string>");
 
     if (mVerbosity>0){
             std::cout << mLegend << "Branch " << name_type
@@ -291,5 +332,39 @@ int LjmetEventContent::createBranches()
         }
     }
 
+    if (!mPrecision.Empty()) {
+        std::cout << mLegend << "double branches stored with reduced precision: "
+        << mvReducedBranch.size() + mvReducedVectorBranch.size() << std::endl;
+        mPrecision.Print(std::cout);
+    }
+
     return 0;
 }
+
+
+void LjmetEventContent::fillTree()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    mpTree->Fill();
+    mTuning.AfterFill(mpTree, std::chrono::steady_clock::now() - start);
+    if (mpWriteProfiler) mpWriteProfiler->Stop(mWriteTimer, start);
+}
+
+
+void LjmetEventContent::FinishTree()
+{
+    if (!mpWriter) return;
+    mpWriter->Finish();
+    mpWriter->Print(std::cout);
+}
+
+
+void LjmetEventContent::reducePrecision()
+{
+    for (auto const & br : mvReducedBranch) *br.target = BranchPrecision::Reduce(*br.source, *br.rule);
+
+    for (auto const & br : mvReducedVectorBranch) {
+        br.target->resize(br.source->size());
+        for (unsigned int i = 0; i < br.source->size(); ++i) (*br.target)[i] = BranchPrecision::Reduce((*br.source)[i], *br.rule);
+    }
+}
@@ -3,7 +3,7 @@
 // Ensure a single instance
 LjmetFactory * LjmetFactory::instance = 0;
 
-LjmetFactory::LjmetFactory(): theSelector(0)
+LjmetFactory::LjmetFactory(): theSelector(0), mpProfiler(0), mpAllocProfiler(0)
 {
     mLegend = "[LjmetFactory]: ";
 }
@@ -73,12 +73,21 @@ BaseEventSelector * LjmetFactory::GetEventSelector(std::string name)
     return theSelector;
 }
 
+BaseCalc * LjmetFactory::GetCalculator(std::string name)
+{
+    std::map<std::string, BaseCalc * >::const_iterator calc = mpCalculators.find(name);
+    if (calc == mpCalculators.end()) return 0;
+    return calc->second;
+}
+
 void LjmetFactory::RunAllCalculators(edm::Event const & event, BaseEventSelector * selector, LjmetEventContent & ec, std::vector<std::string> vIncl)
 {
     for (std::vector<std::string>::const_iterator it = vIncl.begin(); it != vIncl.end(); ++it){
     
     	if(mpCalculators.find(*it)!=mpCalculators.end()){
     		mpCalculators[*it]->SetEventContent(&ec);
+    		LatencyProfiler::Scope scope(mpProfiler, mpProfiler ? mAnalyzeTimers[*it] : 0);
+    		AllocationProfiler::Scope allocScope(mpAllocProfiler, mpAllocProfiler ? mAnalyzeAllocProbes[*it] : 0);
     		mpCalculators[*it]->AnalyzeEvent(event, selector);
     		
     	}
@@ -93,6 +102,8 @@ void LjmetFactory::RunAllProducers(edm::EventBase const & event, BaseEventSelect
     // run all producer methods (comes before selection)
     for (std::vector<std::string>::const_iterator it = vIncl.begin(); it != vIncl.end(); ++it){
     	if(mpCalculators.find(*it)!=mpCalculators.end()){
+    		LatencyProfiler::Scope scope(mpProfiler, mpProfiler ? mProduceTimers[*it] : 0);
+    		AllocationProfiler::Scope allocScope(mpAllocProfiler, mpAllocProfiler ? mProduceAllocProbes[*it] : 0);
     		mpCalculators[*it]->ProduceEvent(event, selector);    		
     	}    
     }
@@ -136,6 +147,20 @@ void LjmetFactory::BeginJobAllCalc(edm::ConsumesCollector && iC, std::vector<std
     for (std::vector<std::string>::const_iterator it = vIncl.begin(); it != vIncl.end(); ++it){    
     	if(mpCalculators.find(*it)!=mpCalculators.end()){
     		mpCalculators[*it]->BeginJob((edm::ConsumesCollector &&)iC);    		
+
+    		if (mpProfiler) {
+    			mProduceTimers[*it] = mpProfiler->Register(*it, "ProduceEvent");
+    			mAnalyzeTimers[*it] = mpProfiler->Register(*it, "AnalyzeEvent");
+    		}
+    		if (mpAllocProfiler) {
+    			mProduceAllocProbes[*it] = mpAllocProfiler->Register(*it, "ProduceEvent");
+    			mAnalyzeAllocProbes[*it] = mpAllocProfiler->Register(*it, "AnalyzeEvent");
+    		}
+
+    		// pass on the selector collections the calculator reads
+    		for (int collection : mpCalculators[*it]->GetUses()){
+    			if (theSelector) theSelector->DeclareUse((BaseEventSelector::Collection)collection);
+    		}
     	}
     }
 }
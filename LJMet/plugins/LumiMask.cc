@@ -0,0 +1,116 @@
+#include "FWLJMET/LJMet/interface/LumiMask.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+
+LumiMask::LumiMask():
+    mLegend("\t[LumiMask]: "),
+    mCachedRun(0),
+    mCachedLumi(0),
+    mCachedDecision(false)
+{
+}
+
+
+void LumiMask::Load(std::string const & path)
+{
+    std::ifstream file(path.c_str());
+    if (!file) throw cms::Exception("InvalidInput") << "Cannot open lumi mask " << path << std::endl;
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // the golden JSON only holds "run": [[first, last], ...] entries, read the numbers in order
+    std::map<unsigned int, std::vector<Range>> runRanges;
+    unsigned int run = 0;
+    bool inRun = false;
+    std::vector<unsigned int> numbers;
+    int depth = 0;
+
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '"') {
+            std::size_t end = text.find('"', i+1);
+            if (end == std::string::npos) break;
+            std::string key = text.substr(i+1, end-i-1);
+            if (key.empty() || !std::all_of(key.begin(), key.end(), [](char k){ return std::isdigit((unsigned char)k) != 0; }))
+                throw cms::Exception("InvalidInput") << "Lumi mask " << path << ": unexpected key \"" << key << "\"" << std::endl;
+            run = std::stoul(key);
+            inRun = true;
+            i = end;
+        }
+        else if (c == '[') {
+            ++depth;
+            numbers.clear();
+        }
+        else if (c == ']') {
+            if (depth == 2) {
+                if (!inRun || numbers.size() != 2 || numbers[0] > numbers[1])
+                    throw cms::Exception("InvalidInput") << "Lumi mask " << path << ": bad lumi range in run " << run << std::endl;
+                runRanges[run].push_back({numbers[0], numbers[1]});
+            }
+            if (--depth == 0) inRun = false;
+        }
+        else if (std::isdigit((unsigned char)c)) {
+            std::size_t end = i;
+            while (end < text.size() && std::isdigit((unsigned char)text[end])) ++end;
+            numbers.push_back(std::stoul(text.substr(i, end-i)));
+            i = end-1;
+        }
+    }
+
+    mvRuns.clear();
+    mvFirst.clear();
+    mvRanges.clear();
+    for (auto & entry : runRanges) {
+        std::vector<Range> & ranges = entry.second;
+        std::sort(ranges.begin(), ranges.end(), [](Range const & a, Range const & b){ return a.first < b.first; });
+
+        mvRuns.push_back(entry.first);
+        mvFirst.push_back(mvRanges.size());
+        for (auto const & range : ranges) {
+            // merge overlapping or adjacent ranges
+            if (mvRanges.size() > mvFirst.back() && range.first <= mvRanges.back().last+1) mvRanges.back().last = std::max(mvRanges.back().last, range.last);
+            else mvRanges.push_back(range);
+        }
+    }
+    mvFirst.push_back(mvRanges.size());
+
+    mCachedRun = 0;
+    mCachedLumi = 0;
+    mCachedDecision = false;
+
+    std::cout << mLegend << "loaded " << path << std::endl;
+    Print(std::cout);
+}
+
+
+bool LumiMask::lookup(unsigned int run, unsigned int lumi) const
+{
+    std::vector<unsigned int>::const_iterator iRun = std::lower_bound(mvRuns.begin(), mvRuns.end(), run);
+    if (iRun == mvRuns.end() || *iRun != run) return false;
+
+    std::size_t i = iRun - mvRuns.begin();
+    std::vector<Range>::const_iterator begin = mvRanges.begin() + mvFirst[i];
+    std::vector<Range>::const_iterator end   = mvRanges.begin() + mvFirst[i+1];
+
+    // last range starting at or before lumi
+    std::vector<Range>::const_iterator iRange = std::upper_bound(begin, end, lumi, [](unsigned int l, Range const & r){ return l < r.first; });
+    if (iRange == begin) return false;
+    return lumi <= (iRange-1)->last;
+}
+
+
+void LumiMask::Print(std::ostream & out) const
+{
+    unsigned long long nLumis = 0;
+    for (auto const & range : mvRanges) nLumis += range.last - range.first + 1;
+
+    out << mLegend << mvRuns.size() << " runs";
+    if (!mvRuns.empty()) out << " (" << mvRuns.front() << " to " << mvRuns.back() << ")";
+    out << ", " << mvRanges.size() << " lumi ranges, " << nLumis << " lumi sections certified" << std::endl;
+}
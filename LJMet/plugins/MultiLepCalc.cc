@@ -8,6 +8,9 @@
 #include "DataFormats/HLTReco/interface/TriggerEvent.h"
 
 #include "FWLJMET/LJMet/interface/MiniIsolation.h"
+#include "FWLJMET/LJMet/interface/AngularMatcher.h"
+#include "FWLJMET/LJMet/interface/PDFReweighter.h"
+#include "FWLJMET/LJMet/interface/LHEWeightSchema.h"
 
 #include "FWLJMET/LJMet/interface/JetMETCorrHelper.h"
 #include "FWLJMET/LJMet/interface/BTagSFUtil.h"
@@ -32,7 +35,7 @@ public:
     virtual ~MultiLepCalc();
     virtual int BeginJob(edm::ConsumesCollector && iC);
     virtual int AnalyzeEvent(edm::Event const & event, BaseEventSelector * selector);
-    virtual int EndJob(){return 0;};
+    virtual int EndJob();
 
     void AnalyzeTriggers(edm::Event const & event, BaseEventSelector * selector);
     void AnalyzePV(edm::Event const & event, BaseEventSelector * selector);
@@ -61,6 +64,9 @@ private:
     bool   JERdown;
     bool doAllJetSyst;
     JetMETCorrHelper JetMETCorr;
+    // MET flavours summed from the selector's type-1 deltas / corrected here, printed at EndJob
+    unsigned long long nMetShared = 0;
+    unsigned long long nMetCorrected = 0;
 
     BTagSFUtil btagSfUtil;
 
@@ -68,6 +74,9 @@ private:
     bool orlhew;
     std::string basePDFname;
     std::string newPDFname;
+    PDFReweighter pdfReweighter;
+    LHEWeightSchema lheWeightSchema;
+    std::vector<double> lheWeightBuffer;
     std::vector<unsigned int> keepPDGID;
     std::vector<unsigned int> keepMomPDGID;
     std::vector<unsigned int> keepPDGIDForce;
@@ -80,6 +89,7 @@ private:
     edm::EDGetTokenT<edm::TriggerResults >             muflagtagToken;
     edm::EDGetTokenT<double>                           rhoJetsNCToken;
     edm::EDGetTokenT<double>                           rhoJetsToken;
+    edm::InputTag                                      rhoJetsTag;
     edm::EDGetTokenT<pat::PackedCandidateCollection>   PFCandToken;
     edm::EDGetTokenT<reco::GenParticleCollection>      genParticlesToken;
     edm::EDGetTokenT<std::vector<pat::MET> >           METnoHFtoken;
@@ -90,8 +100,10 @@ private:
 
 
     //helper functions
-    int findMatch(const reco::GenParticleCollection & genParticles, int idToMatch, double eta, double phi);
-    double mdeltaR(double eta1, double phi1, double eta2, double phi2);
+    void fillGenMatcher(const GenParticleIndex & genIndex, int idToMatch);
+    int findMatch(double eta, double phi, double & closestDR);
+    AngularMatcher genMatcher;
+    std::vector<unsigned int> genMatcherIndices;
     void fillMotherInfo(const reco::Candidate *mother,
 			int i,
 			std::vector <int> & momid,
@@ -121,6 +133,10 @@ int MultiLepCalc::BeginJob(edm::ConsumesCollector && iC)
 
 	std::cout << "["+GetName()+"]: "<< "initializing parameters" << std::endl;
 
+	//selector collections built on demand
+	DeclareUse(BaseEventSelector::kSelCorrJetsAK8);
+	DeclareUse(BaseEventSelector::kCorrectedMet);
+
 	//do consumes here if need to access input file directly
 
 	//PU info
@@ -132,7 +148,8 @@ int MultiLepCalc::BeginJob(edm::ConsumesCollector && iC)
 	//Misc
 	rhoJetsNCToken      = iC.consumes<double>(mPset.getParameter<edm::InputTag>("rhoJetsNCInputTag"));
 	PFCandToken         = iC.consumes<pat::PackedCandidateCollection>(mPset.getParameter<edm::InputTag>("PFparticlesCollection"));
-	rhoJetsToken        = iC.consumes<double>(mPset.getParameter<edm::InputTag>("rhoJetsInputTag"));
+	rhoJetsTag          = mPset.getParameter<edm::InputTag>("rhoJetsInputTag");
+	rhoJetsToken        = iC.consumes<double>(rhoJetsTag);
 
 
 	//Gen
@@ -144,6 +161,7 @@ int MultiLepCalc::BeginJob(edm::ConsumesCollector && iC)
 	orlhew              = mPset.getParameter<bool>("OverrideLHEWeights");
 	basePDFname         = mPset.getParameter<std::string>("basePDFname");
 	newPDFname          = mPset.getParameter<std::string>("newPDFname");
+	lheWeightSchema.SetKeepRanges(mPset.getUntrackedParameter<std::vector<int> >("keepLHEWeightIds", std::vector<int>()));
 	keepPDGID           = mPset.getParameter<std::vector<unsigned int> >("keepPDGID");
 	keepMomPDGID        = mPset.getParameter<std::vector<unsigned int> >("keepMomPDGID");
 	keepPDGIDForce      = mPset.getParameter<std::vector<unsigned int> >("keepPDGIDForce");
@@ -155,6 +173,7 @@ int MultiLepCalc::BeginJob(edm::ConsumesCollector && iC)
 	  std::cout << "["+GetName()+"]: "<< "Overriding LHE weights, using "<<newPDFname<<" as new and "<<basePDFname<<" as base PDF set." << std::endl;
 	  LHAPDF::Info& cfg = LHAPDF::getConfig();
 	  cfg.set_entry("Verbosity", 0);
+	  pdfReweighter.Initialize(basePDFname, newPDFname);
 	}
 
 	//Electron
@@ -185,6 +204,13 @@ int MultiLepCalc::BeginJob(edm::ConsumesCollector && iC)
 	return 0;
 }
 
+int MultiLepCalc::EndJob()
+{
+	JetMETCorr.PrintWarnings(std::cout);
+	std::cout << "["+GetName()+"]: " << "MET flavours from the selector's type-1 deltas: " << nMetShared << ", corrected here: " << nMetCorrected << std::endl;
+	return 0;
+}
+
 int MultiLepCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selector)
 {
 
@@ -346,6 +372,7 @@ void MultiLepCalc::AnalyzeMuon(edm::Event const & event, BaseEventSelector * sel
 
 	edm::Handle<reco::GenParticleCollection> genParticles;
 	event.getByToken(genParticlesToken, genParticles);
+	if(isMc && keepFullMChistory) fillGenMatcher(selector->GetGenParticleIndex(genParticles), 13);
 
 
 	//
@@ -489,11 +516,10 @@ void MultiLepCalc::AnalyzeMuon(edm::Event const & event, BaseEventSelector * sel
             muNValPixelHits    . push_back((*imu)->innerTrack()->hitPattern().numberOfValidPixelHits());
             muNTrackerLayers   . push_back((*imu)->innerTrack()->hitPattern().trackerLayersWithMeasurement());
             if(isMc && keepFullMChistory){
-                int matchId = findMatch(*genParticles, 13, (*imu)->eta(), (*imu)->phi());
                 double closestDR = 10000.;
+                int matchId = findMatch((*imu)->eta(), (*imu)->phi(), closestDR);
                 if (matchId>=0) {
                     const reco::GenParticle & p = (*genParticles).at(matchId);
-                    closestDR = mdeltaR( (*imu)->eta(), (*imu)->phi(), p.eta(), p.phi());
                     if(closestDR < 0.3){
                         muGen_Reco_dr.push_back(closestDR);
                         muPdgId.push_back(p.pdgId());
@@ -611,6 +637,7 @@ void MultiLepCalc::AnalyzeElectron(edm::Event const & event, BaseEventSelector *
 
 	edm::Handle<reco::GenParticleCollection> genParticles;
 	event.getByToken(genParticlesToken, genParticles);
+	if(isMc && keepFullMChistory) fillGenMatcher(selector->GetGenParticleIndex(genParticles), 11);
 
 	edm::Handle<double> rhoHandle;
 	event.getByToken(rhoJetsToken, rhoHandle);
@@ -825,12 +852,11 @@ void MultiLepCalc::AnalyzeElectron(edm::Event const & event, BaseEventSelector *
 
             if(isMc && keepFullMChistory){
                 //cout << "start\n";
-                int matchId = findMatch(*genParticles, 11, (*iel)->eta(), (*iel)->phi());
                 double closestDR = 10000.;
+                int matchId = findMatch((*iel)->eta(), (*iel)->phi(), closestDR);
                 //cout << "matchId "<<matchId <<endl;
                 if (matchId>=0) {
                     const reco::GenParticle & p = (*genParticles).at(matchId);
-                    closestDR = mdeltaR( (*iel)->eta(), (*iel)->phi(), p.eta(), p.phi());
                     //cout << "closestDR "<<closestDR <<endl;
                     if(closestDR < 0.3){
                         elGen_Reco_dr.push_back(closestDR);
@@ -951,7 +977,8 @@ void MultiLepCalc::AnalyzeJets(edm::Event const & event, BaseEventSelector * sel
 
 	// ----- Get objects from the selector -----
 
-	std::vector<pat::Jet>                       const & vSelCorrJets       = selector->GetSelCorrJets();
+	std::vector<edm::Ptr<pat::Jet>>             const & vSelJets           = selector->GetSelJets();
+	std::vector<CorrectedJet>                   const & vSelCorrJetRecords = selector->GetSelCorrJetRecords();
 	std::vector<std::pair<TLorentzVector,bool>> const & vCorrBtagJets      = selector->GetSelCorrJetsWithBTags();
 
     //
@@ -988,32 +1015,33 @@ void MultiLepCalc::AnalyzeJets(edm::Event const & event, BaseEventSelector * sel
 
     //std::vector <double> AK4JetRCN;
     double AK4HT =.0;
-    for (std::vector<pat::Jet>::const_iterator ii = vSelCorrJets.begin(); ii != vSelCorrJets.end(); ii++){
-      int index = (int)(ii-vSelCorrJets.begin());
+    for (std::vector<CorrectedJet>::const_iterator ii = vSelCorrJetRecords.begin(); ii != vSelCorrJetRecords.end(); ii++){
+      int index = (int)(ii-vSelCorrJetRecords.begin());
+      const pat::Jet & jet = *vSelJets[index]; // source jet, for tags and flavour
 
-      AK4JetPt     . push_back(ii->pt());
-      AK4JetEta    . push_back(ii->eta());
-      AK4JetPhi    . push_back(ii->phi());
-      AK4JetEnergy . push_back(ii->energy());
+      AK4JetPt     . push_back(ii->p4.pt());
+      AK4JetEta    . push_back(ii->p4.eta());
+      AK4JetPhi    . push_back(ii->p4.phi());
+      AK4JetEnergy . push_back(ii->p4.energy());
 
       AK4JetBTag   . push_back(vCorrBtagJets[index].second);
 
-      TLorentzVector jetP4; jetP4.SetPtEtaPhiE(ii->pt(), ii->eta(), ii->phi(), ii->energy() );
+      TLorentzVector jetP4; jetP4.SetPtEtaPhiE(ii->p4.pt(), ii->p4.eta(), ii->p4.phi(), ii->p4.energy() );
 
-      AK4JetBTag_bSFup.push_back(btagSfUtil.isJetTagged(*ii,jetP4, event, isMc, 1));
-      AK4JetBTag_bSFdn.push_back(btagSfUtil.isJetTagged(*ii,jetP4, event, isMc, 2));
-      AK4JetBTag_lSFup.push_back(btagSfUtil.isJetTagged(*ii,jetP4, event, isMc, 3));
-      AK4JetBTag_lSFdn.push_back(btagSfUtil.isJetTagged(*ii,jetP4, event, isMc, 4));
+      AK4JetBTag_bSFup.push_back(btagSfUtil.isJetTagged(jet, ii->p4.phi(), jetP4, event, isMc, 1));
+      AK4JetBTag_bSFdn.push_back(btagSfUtil.isJetTagged(jet, ii->p4.phi(), jetP4, event, isMc, 2));
+      AK4JetBTag_lSFup.push_back(btagSfUtil.isJetTagged(jet, ii->p4.phi(), jetP4, event, isMc, 3));
+      AK4JetBTag_lSFdn.push_back(btagSfUtil.isJetTagged(jet, ii->p4.phi(), jetP4, event, isMc, 4));
 
-      AK4JetBDisc        . push_back(ii->bDiscriminator( "pfCombinedInclusiveSecondaryVertexV2BJetTags" ));
-      AK4JetBDeepCSVb    . push_back(ii->bDiscriminator( "pfDeepCSVJetTags:probb" ));
-      AK4JetBDeepCSVbb   . push_back(ii->bDiscriminator( "pfDeepCSVJetTags:probbb" ));
-      AK4JetBDeepCSVc    . push_back(ii->bDiscriminator( "pfDeepCSVJetTags:probc" ));
-      AK4JetBDeepCSVudsg . push_back(ii->bDiscriminator( "pfDeepCSVJetTags:probudsg" ));
-      AK4JetFlav         . push_back(abs(ii->hadronFlavour()));
+      AK4JetBDisc        . push_back(jet.bDiscriminator( "pfCombinedInclusiveSecondaryVertexV2BJetTags" ));
+      AK4JetBDeepCSVb    . push_back(jet.bDiscriminator( "pfDeepCSVJetTags:probb" ));
+      AK4JetBDeepCSVbb   . push_back(jet.bDiscriminator( "pfDeepCSVJetTags:probbb" ));
+      AK4JetBDeepCSVc    . push_back(jet.bDiscriminator( "pfDeepCSVJetTags:probc" ));
+      AK4JetBDeepCSVudsg . push_back(jet.bDiscriminator( "pfDeepCSVJetTags:probudsg" ));
+      AK4JetFlav         . push_back(abs(jet.hadronFlavour()));
 
       //HT
-      AK4HT += ii->pt();
+      AK4HT += ii->p4.pt();
     }
 
 //     double AK4HT_jesup =.0;
@@ -1173,6 +1201,7 @@ void MultiLepCalc::AnalyzeMET(edm::Event const & event, BaseEventSelector * sele
 	std::vector<edm::Ptr<pat::Jet>>             const & vAllJets           = selector->GetAllJets();
 	edm::Ptr<pat::MET>                          const & pMet               = selector->GetMet();
 	TLorentzVector                              const & corrMET_p4         = selector->GetCorrectedMet();
+	Type1MET                                    const & type1MET           = selector->GetType1MET();
 
 
     //
@@ -1187,6 +1216,16 @@ void MultiLepCalc::AnalyzeMET(edm::Event const & event, BaseEventSelector * sele
     else if (JERdown){syst=4;}
     else syst = 0; //nominal
 
+    // all MET flavours are summed from the selector's per-jet type-1 deltas (each jet corrected once)
+    // if the selector corrected the jets with the same JEC/JER files, isMc and rho as this calculator;
+    // otherwise, and for variations the selector did not compute, they are corrected here
+    bool const sameCorrection = type1MET.SameCorrection(doNewJEC, JetMETCorr.ConfigKey(), rhoJetsTag);
+    auto correctMet = [&](pat::MET const & met, unsigned int v, bool useHF) {
+        if (sameCorrection && type1MET.Has(v)) { nMetShared++; return type1MET.Apply(met, v, useHF); }
+        nMetCorrected++;
+        return JetMETCorr.correctMet(met, event, rhoJetsToken, vAllJets, doNewJEC, v, useHF);
+    };
+
     double _met = -9999.0;
     double _met_phi = -9999.0;
     // Corrected MET
@@ -1209,7 +1248,7 @@ void MultiLepCalc::AnalyzeMET(edm::Event const & event, BaseEventSelector * sele
 
             if (!doAllJetSyst) break;
 
-            TLorentzVector corrMET = JetMETCorr.correctMet(*pMet, event, rhoJetsToken, vAllJets, doNewJEC, corri);
+            TLorentzVector corrMET = correctMet(*pMet, corri, true);
 
             if(corrMET.Pt()>0) {
                 _corr_met.push_back(corrMET.Pt());
@@ -1253,7 +1292,7 @@ void MultiLepCalc::AnalyzeMET(edm::Event const & event, BaseEventSelector * sele
         _metnohf = metnohf->p4().pt();
         _metnohf_phi = metnohf->p4().phi();
 
-        TLorentzVector corrMETNOHF = JetMETCorr.correctMet(*metnohf, event, rhoJetsToken, vAllJets, doNewJEC, syst, useHF);
+        TLorentzVector corrMETNOHF = correctMet(*metnohf, syst, useHF);
         //std::cout<<(selector->GetCleanedCorrMet()).Pt()<<std::endl;
         if(corrMETNOHF.Pt()>0) {
 	  _corr_metnohf = corrMETNOHF.Pt();
@@ -1280,7 +1319,7 @@ void MultiLepCalc::AnalyzeMET(edm::Event const & event, BaseEventSelector * sele
         _metmod = metmod->p4().pt();
         _metmod_phi = metmod->p4().phi();
 
-        TLorentzVector corrMETMOD = JetMETCorr.correctMet(*metmod, event, rhoJetsToken, vAllJets, doNewJEC, syst, useHF);
+        TLorentzVector corrMETMOD = correctMet(*metmod, syst, useHF);
         //std::cout<<(selector->GetCleanedCorrMet()).Pt()<<std::endl;
         if(corrMETMOD.Pt()>0) {
 	  _corr_metmod = corrMETMOD.Pt();
@@ -1324,8 +1363,9 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
     //event weights
     std::vector<double> evtWeightsMC;
     float MCWeight=1;
-    std::vector<double> LHEweights;
-    std::vector<int> LHEweightids;
+    static const std::vector<int> noLHEweightids;
+    bool hasLHEweights = false;
+    lheWeightBuffer.clear();
 
     std::vector <double> genJetPt;
     std::vector <double> genJetEta;
@@ -1371,60 +1411,20 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
           //std::cout<<"x1 x2 Q id1 id2"<<std::endl;
           //std::cout<<x1<<" "<<x2<<" "<<Q<<" "<<id1<<" "<<id2<<std::endl;
 
-          //Initialize PDF sets
-          LHAPDF::PDF* basepdf1 = LHAPDF::mkPDF(basePDFname,0);
-          const LHAPDF::GridPDF& pdf1 = * dynamic_cast<const LHAPDF::GridPDF*>(basepdf1);
-
-          // calculate central PDFs for generator set,
-          double pdf1_gen = pdf1.xfxQ(id1, x1, Q);
-          double pdf2_gen = pdf1.xfxQ(id2, x2, Q);
-          //std::cout<<"pdf1_gen = "<<pdf1_gen<<" pdf2_gen = "<<pdf2_gen<<std::endl;
-          delete basepdf1;
-
-          const LHAPDF::PDFSet newset(newPDFname);
-          const size_t nmem = newset.size();
-          const std::vector<LHAPDF::PDF*> newpdfs = newset.mkPDFs();
-          for (size_t i = 0; i<nmem; i++) {
-            const LHAPDF::GridPDF& pdf2 = * dynamic_cast<const LHAPDF::GridPDF*>(newpdfs[i]);
-
-            double pdf1_new = pdf2.xfxQ(id1, x1, Q);
-            double pdf2_new = pdf2.xfxQ(id2, x2, Q);
-            NewPDFweights.push_back((pdf1_new*pdf2_new)/(pdf1_gen*pdf2_gen));
-            NewPDFweightsBase.push_back(pdf1_gen*pdf2_gen);
-            NewPDFids.push_back(315000+i);
-
-            delete (newpdfs[i]);
-          }
+          // base and new PDF members are resident since BeginJob
+          double pdfBase;
+          pdfReweighter.Evaluate(id1, x1, id2, x2, Q, NewPDFweights, pdfBase);
+          NewPDFweightsBase.assign(NewPDFweights.size(), pdfBase);
+          for (size_t i = 0; i<NewPDFweights.size(); i++) NewPDFids.push_back(315000+i);
         }
         edm::Handle<LHEEventProduct> EvtHandle;
         if(event.getByToken(LHEToken,EvtHandle)){
 
             // Save LHE-level HT calculation from quarks:
             if(saveGenHT){
-
-                // Save the madgraph event weight
-                const lhef::HEPEUP& lheEvent =EvtHandle->hepeup();
-
-                // Loop over HepEvent entries
-                std::vector<lhef::HEPEUP::FiveVector> lheParticles = lheEvent.PUP;
-                size_t numParticles = lheParticles.size();
-                for(size_t idxParticle = 0; idxParticle < numParticles; ++idxParticle){
-
-                    // PDG ID
-                    int absPdgId = TMath::Abs(lheEvent.IDUP[idxParticle]);
-
-                    // Particle status
-                    int status = lheEvent.ISTUP[idxParticle];
-
-                    // Sum up pt and multiplicity of status 1 quarks and gluons
-                    if(status == 1 && ((absPdgId >= 1 && absPdgId <= 6) || absPdgId == 21)){
-
-                        HTfromHEPEUP += TMath::Sqrt(TMath::Power(lheParticles[idxParticle][0], 2.) + TMath::Power(lheParticles[idxParticle][1], 2.));
-                        NPartonsfromHEPEUP++;
-
-                    }
-                }
-
+                LHESummary const & lheSummary = selector->GetLHESummary(EvtHandle);
+                HTfromHEPEUP       = lheSummary.HT();
+                NPartonsfromHEPEUP = lheSummary.NPartons();
             }
 
             // Storing LHE weights https://twiki.cern.ch/twiki/bin/viewauth/CMS/LHEReaderCMSSW
@@ -1437,15 +1437,11 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
 
             LHEweightorig = EvtHandle->originalXWGTUP();
 
-            std::string weightidstr;
-            int weightid;
+            // weight id layout is resolved once per run, only the weights are copied per event
             if(EvtHandle->weights().size() > 0){
-                for(unsigned int i = 0; i < EvtHandle->weights().size(); i++){
-                    weightidstr = EvtHandle->weights()[i].id;
-                    weightid = std::stoi(weightidstr);
-                    LHEweights.push_back(EvtHandle->weights()[i].wgt/EvtHandle->originalXWGTUP());
-                    LHEweightids.push_back(weightid);
-                }
+                lheWeightSchema.Update(event.id().run(), EvtHandle->weights());
+                lheWeightSchema.Fill(EvtHandle->weights(), EvtHandle->originalXWGTUP(), lheWeightBuffer);
+                hasLHEweights = true;
             }
 
         }
@@ -1457,11 +1453,19 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
         edm::Handle<std::vector< reco::GenJet> > genJets;
         event.getByToken(genJetsToken, genJets);
 
+        const GenParticleIndex & genIndex = selector->GetGenParticleIndex(genParticles);
+
+        // only status 1 leptons, status 23 and the force-saved statuses can be stored
+        std::vector<int> storedStatuses = {1, 23};
+        for (unsigned int ii = 0; ii < keepStatusForce.size(); ii++) storedStatuses.push_back((int) keepStatusForce.at(ii));
+        std::vector<unsigned int> candidates;
+        genIndex.SelectStatuses(storedStatuses, candidates);
+
         //std::cout << "---------------------------------" << std::endl;
         //std::cout << "\tStatus\tmoment\tmass\tpt\teta\tphi\tID\tMomID\tMomStat\tGMomID\tGMomSt\tGGMomID\tGGMomSt" << std::endl;
         //std::cout << std::endl;
 
-        for(size_t i = 0; i < genParticles->size(); i++){
+        for(size_t i : candidates){
             const reco::GenParticle & p = (*genParticles).at(i);
 
             bool forceSave = false;
@@ -1534,9 +1538,8 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
 
                 //Find index of mother
                 int mInd = 0;
-                for(size_t j = 0; j < genParticles->size(); j++){
+                for(size_t j : genIndex.WithStatus(3)){
                     const reco::GenParticle & q = (*genParticles).at(j);
-                    if (q.status() != 3) continue;
                     if (mother->pdgId() == q.pdgId() and fabs(mother->eta() - q.eta()) < 0.01 and fabs(mother->pt() - q.pt()) < 0.01){
                         mInd = (int) j;
                         break;
@@ -1575,25 +1578,31 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
         TLorentzVector tmpLep;
         TLorentzVector tmpCand;
         std::vector<TLorentzVector> tmpVec;
+        std::vector<TLorentzVector> jetNus;
+        std::vector<unsigned int> overlaps;
+        AngularMatcher jetLepMatcher;
         for(const reco::GenJet &j : *genJets){
             tmpJet.SetPtEtaPhiE(j.pt(),j.eta(),j.phi(),j.energy());
             if (cleanGenJets) {
-	            for(size_t k = 0; k < vGenLep.size(); k++){
+                // lepton and neutrino constituents, collected once per jet
+                jetNus.clear();
+                jetLepMatcher.Clear();
+                for (unsigned int id = 0, nd = j.numberOfDaughters(); id < nd; ++id) {
+		  if ( !(j.daughterPtr(id).isNonnull()) ) continue;
+		  if ( !(j.daughterPtr(id).isAvailable()) ) continue;
+		  const reco::Candidate &_ijet_const = dynamic_cast<const reco::Candidate &>(*j.daughter(id));
+		  int absId = abs(_ijet_const.pdgId());
+		  if (absId!=11 && absId!=13 && absId!=12 && absId!=14 && absId!=16) continue;
+		  tmpCand.SetPtEtaPhiE(_ijet_const.pt(),_ijet_const.eta(),_ijet_const.phi(),_ijet_const.energy());
+		  if (absId==11 || absId==13) jetLepMatcher.Add(tmpCand.Eta(), tmpCand.Phi());
+		  else jetNus.push_back(tmpCand);
+                }
+	        for(size_t k = 0; k < vGenLep.size(); k++){
                     tmpLep = vGenLep[k];
-	                for (unsigned int id = 0, nd = j.numberOfDaughters(); id < nd; ++id) {
-			  if ( !(j.daughterPtr(id).isNonnull()) ) continue;
-			  if ( !(j.daughterPtr(id).isAvailable()) ) continue;
-			  const reco::Candidate &_ijet_const = dynamic_cast<const reco::Candidate &>(*j.daughter(id));
-			  tmpCand.SetPtEtaPhiE(_ijet_const.pt(),_ijet_const.eta(),_ijet_const.phi(),_ijet_const.energy());
-			  if ( tmpLep.DeltaR(tmpCand) < 0.001 && (abs(_ijet_const.pdgId())==13 || abs(_ijet_const.pdgId())==11) ) {//genjet cleaning to mimic reco jet cleaning
-	                    //std::cout<<"Found overlap:"<<std::endl;
-	                    //std::cout<<"Gen Lep      : pt = "<<tmpLep.Pt()<<", eta = "<<tmpLep.Eta()<<", phi = "<<tmpLep.Phi()<<std::endl;
-	                    //std::cout<<"Gen Jet      : pt = "<<tmpJet.Pt()<<", eta = "<<tmpJet.Eta()<<", phi = "<<tmpJet.Phi()<<std::endl;
-	                    //std::cout<<"Gen Jet Const: pt = "<<tmpCand.Pt()<<", eta = "<<tmpCand.Eta()<<", phi = "<<tmpCand.Phi()<<std::endl;
-	                    tmpJet = tmpJet - tmpLep;
- 	                }
-                        if (abs(_ijet_const.pdgId())==12 || abs(_ijet_const.pdgId())==14 || abs(_ijet_const.pdgId())==16) tmpJet = tmpJet - tmpCand;//temporary fix for neutrinos being included in genjets, can be removed in later releases (i.e. >74X)
-                    }
+                    //genjet cleaning to mimic reco jet cleaning: remove the lepton once per overlapping constituent
+                    jetLepMatcher.Within(tmpLep.Eta(), tmpLep.Phi(), 0.001, overlaps);
+                    for (size_t io = 0; io < overlaps.size(); io++) tmpJet = tmpJet - tmpLep;
+                    for (size_t in = 0; in < jetNus.size(); in++) tmpJet = tmpJet - jetNus[in];//temporary fix for neutrinos being included in genjets, can be removed in later releases (i.e. >74X)
                 }
             }
             tmpVec.push_back(tmpJet);
@@ -1642,8 +1651,8 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
     SetValue("evtWeightsMC", evtWeightsMC);
     SetValue("MCWeight", MCWeight);
     SetValue("LHEweightorig", LHEweightorig);
-    SetValue("LHEweights", LHEweights);
-    SetValue("LHEweightids", LHEweightids);
+    SetValue("LHEweights", lheWeightBuffer);
+    SetValue("LHEweightids", hasLHEweights ? lheWeightSchema.Ids() : noLHEweightids);
     SetValue("NewPDFids", NewPDFids);
     SetValue("NewPDFweights", NewPDFweights);
     SetValue("NewPDFweightsBase", NewPDFweightsBase);
@@ -1653,26 +1662,24 @@ void MultiLepCalc::AnalyzeGenInfo(edm::Event const & event, BaseEventSelector *
 
 }
 
-int MultiLepCalc::findMatch(const reco::GenParticleCollection & genParticles, int idToMatch, double eta, double phi)
+void MultiLepCalc::fillGenMatcher(const GenParticleIndex & genIndex, int idToMatch)
 {
-    float dRtmp = 1000;
-    float closestDR = 10000.;
-    int closestGenPart = -1;
-
-    for(size_t j = 0; j < genParticles.size(); ++ j) {
-        const reco::GenParticle & p = (genParticles).at(j);
-        dRtmp = mdeltaR( eta, phi, p.eta(), p.phi());
-        if ( dRtmp < closestDR && abs(p.pdgId()) == idToMatch){// && dRtmp < 0.3) {
-            closestDR = dRtmp;
-            closestGenPart = j;
-        }//end of requirement for matching
-    }//end of gen particle loop
-    return closestGenPart;
+    const reco::GenParticleCollection & genParticles = genIndex.Particles();
+
+    genMatcher.Clear();
+    genMatcherIndices = genIndex.WithAbsPdgId(idToMatch);
+    for(unsigned int j : genMatcherIndices) genMatcher.Add(genParticles[j].eta(), genParticles[j].phi());
 }
 
+int MultiLepCalc::findMatch(double eta, double phi, double & closestDR)
+{
+    // only matches within 0.3 are kept by the callers
+    double closestDR2 = 0;
+    int closestGenPart = genMatcher.Nearest(eta, phi, 0.3, closestDR2);
+    if (closestGenPart < 0) return -1;
 
-double MultiLepCalc::mdeltaR(double eta1, double phi1, double eta2, double phi2) {
-    return std::sqrt(deltaR2 (eta1, phi1, eta2, phi2));
+    closestDR = std::sqrt(closestDR2);
+    return genMatcherIndices[closestGenPart];
 }
 
 void MultiLepCalc::fillMotherInfo(const reco::Candidate *mother, int i, std::vector <int> & momid, std::vector <int> & momstatus, std::vector<double> & mompt, std::vector<double> & mometa, std::vector<double> & momphi, std::vector<double> & momenergy)
@@ -24,9 +24,13 @@
 #include <TRandom3.h>
 #include <boost/algorithm/string.hpp>
 #include <regex>
+#include <algorithm>
 
 #include "FWLJMET/LJMet/interface/JetMETCorrHelper.h"
 #include "FWLJMET/LJMet/interface/BTagSFUtil.h"
+#include "FWLJMET/LJMet/interface/StagedCutFlow.h"
+#include "FWLJMET/LJMet/interface/LumiMask.h"
+#include "FWCore/ParameterSet/interface/FileInPath.h"
 
 
 using namespace std;
@@ -60,6 +64,10 @@ protected:
     bool isMc;
 
 
+    //Certified lumis (data)
+    bool lumi_mask_cut;
+    LumiMask lumiMask;
+
     //Trigger
     bool trigger_cut;
     bool dump_trigger;
@@ -169,6 +177,22 @@ protected:
     bool JetSelection      (edm::Event const & event, pat::strbitset & ret);
     void AK8JetSelection   (edm::Event const & event);
     bool METSelection      (edm::Event const & event);
+    void METCorrection     (edm::Event const & event);
+    void SelCorrJetCopies  ();
+    pat::Jet CorrJetCopy   (const pat::Jet & jet, CorrectedJet const & record, bool reCorrectJet);
+
+    //Collections only calculators read, built on demand
+    virtual void BuildCollection(Collection collection);
+
+    //Cut-flow handles, registered in BeginJob
+    CutHandle cutNoSelection, cutLumiMask, cutTrigger, cutPV, cutMETfilters;
+    CutHandle cutMinLooseLeptons, cutMaxLooseLeptons, cutMinLeptons, cutMaxLeptons;
+    CutHandle cutMinJets, cutMaxJets, cutLeadingJetPt, cutMET, cutAllCuts;
+    CutHandle stepLeptons, stepJets; // histogram only
+
+    //Selection stages, in the order they are run
+    StagedCutFlow cutFlow;
+    void SetupStages();
 
 
 };
@@ -202,6 +226,11 @@ void MultiLepEventSelector::BeginJob( const edm::ParameterSet& iConfig, edm::Con
     //nEvents info
     if(isMc) genToken            = iC.consumes<GenEventInfoProduct>(edm::InputTag("generator"));
 
+    //Certified lumis: golden JSON, absolute or relative to the CMSSW search path, e.g. FWLJMET/LJMet/data/json/Cert_..._JSON.txt
+    std::string lumiJSON = selectorConfig.getUntrackedParameter<std::string>("lumiJSON", "");
+    lumi_mask_cut        = !isMc && !lumiJSON.empty();
+    if(lumi_mask_cut) lumiMask.Load(lumiJSON[0] == '/' ? lumiJSON : edm::FileInPath(lumiJSON).fullPath());
+
     //Trigger
     triggersToken       = iC.consumes<edm::TriggerResults>(selectorConfig.getParameter<edm::InputTag>("HLTcollection"));
     trigger_cut         = selectorConfig.getParameter<bool>("trigger_cut");
@@ -303,6 +332,16 @@ void MultiLepEventSelector::BeginJob( const edm::ParameterSet& iConfig, edm::Con
     PFCandToken          = iC.consumes<pat::PackedCandidateCollection>(selectorConfig.getParameter<edm::InputTag>("PFparticlesCollection"));
     rhoJetsNC_Token      = iC.consumes<double>(selectorConfig.getParameter<edm::InputTag>("rhoJetsNCInputTag"));
     rhoJetsToken         = iC.consumes<double>(selectorConfig.getParameter<edm::InputTag>("rhoJetsInputTag"));
+    mType1MET.SetSource(JetMETCorr.ConfigKey(), selectorConfig.getParameter<edm::InputTag>("rhoJetsInputTag"));
+
+    //AK8 substructure shared with the calculators, subjets corrected with the same JEC/btag setup as the jets
+    unsigned int syst;
+    if (JECup){syst=1;}
+    else if (JECdown){syst=2;}
+    else if (JERup){syst=3;}
+    else if (JERdown){syst=4;}
+    else syst = 0; //nominal
+    mAK8Features.Initialize(&JetMETCorr, &btagSfUtil, rhoJetsToken, doNewJEC, syst, isMc);
 
 
     //-----------------------
@@ -310,22 +349,26 @@ void MultiLepEventSelector::BeginJob( const edm::ParameterSet& iConfig, edm::Con
     //-----------------------
 
     //Reference: "PhysicsTools/SelectorUtils/interface/EventSelector.h"
-    push_back("No selection");
-    push_back("Trigger");
-    push_back("Primary Vertex");
-    push_back("MET filters");
-    push_back("Min Loose Leptons");
-    push_back("Max Loose Leptons");
-    push_back("Min Leptons");
-    push_back("Max Leptons");
-    push_back("Min jet multiplicity");
-    push_back("Max jet multiplicity");
-    push_back("Leading jet pt");
-    push_back("MET");
-    push_back("All cuts");
+    cutNoSelection     = RegisterCut("No selection");
+    if(lumi_mask_cut) cutLumiMask = RegisterCut("Lumi mask"); // data with a lumiJSON only
+    cutTrigger         = RegisterCut("Trigger");
+    cutPV              = RegisterCut("Primary Vertex");
+    cutMETfilters      = RegisterCut("MET filters");
+    cutMinLooseLeptons = RegisterCut("Min Loose Leptons");
+    cutMaxLooseLeptons = RegisterCut("Max Loose Leptons");
+    cutMinLeptons      = RegisterCut("Min Leptons");
+    cutMaxLeptons      = RegisterCut("Max Leptons");
+    cutMinJets         = RegisterCut("Min jet multiplicity");
+    cutMaxJets         = RegisterCut("Max jet multiplicity");
+    cutLeadingJetPt    = RegisterCut("Leading jet pt");
+    cutMET             = RegisterCut("MET");
+    cutAllCuts         = RegisterCut("All cuts");
+    stepLeptons        = RegisterCutStep("Lepton Selection");
+    stepJets           = RegisterCutStep("Jet Selection");
 
     //Reference: "PhysicsTools/SelectorUtils/interface/EventSelector.h"
     set("No selection",true);
+    if(lumi_mask_cut) set("Lumi mask",true);
     set("Trigger",trigger_cut);
     set("Primary Vertex",pv_cut);
     set("MET filters", metfilters);
@@ -347,16 +390,20 @@ void MultiLepEventSelector::BeginJob( const edm::ParameterSet& iConfig, edm::Con
     set("All cuts",true);
 
     //Record cut flow information - will be saved under folder named after the selector name.
-    SetHistogram( "Trigger", 2, 0,2);
-    SetHistogram("Primary Vertex", 2, 0,2);
-    SetHistogram("MET filters", 2, 0,2);
-    SetHistogram("Lepton Selection", 2, 0,2); // keeping it simple for now
+    if(lumi_mask_cut){
+		SetCutHistogram(cutLumiMask);
+    }
+    SetCutHistogram(cutTrigger);
+    SetCutHistogram(cutPV);
+    SetCutHistogram(cutMETfilters);
+    SetCutHistogram(stepLeptons); // keeping it simple for now
     if(jet_cuts){
-		SetHistogram("Jet Selection", 2, 0,2); // keeping it simple for now
+		SetCutHistogram(stepJets); // keeping it simple for now
     }
-    SetHistogram("MET", 2, 0,2);
-    SetHistogram("All cuts", 2, 0,2);
+    SetCutHistogram(cutMET);
+    SetCutHistogram(cutAllCuts);
 
+    SetupStages();
 
 
 
@@ -376,48 +423,15 @@ bool MultiLepEventSelector::operator()( edm::Event const & event, pat::strbitset
       event.getByToken(genToken, genEvtInfo );
       theWeight = genEvtInfo->weight()/fabs(genEvtInfo->weight());
    }
-  FillHist("nEvents", theWeight);
-
-  while(1){ // standard infinite while loop trick to avoid nested ifs
-
-    passCut(ret, "No selection");
-
-    if( ! TriggerSelection(event) ) break;
-    passCut(ret, "Trigger");
-    FillHist("Trigger", 1);
-
-    if( ! PVSelection(event) ) break;
-    passCut(ret, "Primary Vertex");
-    FillHist("Primary Vertex", 1);
-
-    if( ! METfilter(event) ) break;
-    passCut(ret, "MET filters");
-    FillHist("MET filters", 1);
-
-    //Collect selected leptons
-    MuonSelection(event);
-    ElectronSelection(event);
+  FillCutHist(mEventsCut, theWeight);
 
-    if( ! LeptonsSelection(event, ret) ) break;
-    FillHist("Lepton Selection", 1); // keeping it simple for now
-
-    //Collect jets
-    if( ! JetSelection(event, ret) ) break;
-    FillHist("Jet Selection", 1); // keeping it simple for now
-
-    //Collect AK8 jets
-    AK8JetSelection(event);
-
-    if( ! METSelection(event) ) break;
-    passCut(ret, "MET");
-    FillHist("MET", 1);
+  mpEvent = &event;
 
+  PassCut(ret, cutNoSelection);
 
-    passCut(ret, "All cuts");
-    FillHist("All cuts", 1);
-    break;
-
-  } // end of while loop
+  if( cutFlow.Run(event, ret) ){
+    PassCut(ret, cutAllCuts);
+  }
 
 
   bFirstEntry = false;
@@ -445,6 +459,81 @@ void MultiLepEventSelector::AnalyzeEvent( edm::EventBase const & event, LjmetEve
 
 void MultiLepEventSelector::EndJob()
 {
+  cutFlow.Print(std::cout, mLegend);
+  JetMETCorr.PrintWarnings(std::cout);
+}
+
+void MultiLepEventSelector::SetupStages()
+{
+  // Cheap stages first: an event failing any of them never reaches the lepton ID/isolation, JEC or cleaning.
+
+  cutFlow.SetProfiler(mpProfiler, mName);
+  cutFlow.SetAllocationProfiler(mpAllocProfiler, mName);
+
+  // run and lumi come with the event id: uncertified lumis are dropped before any product is read
+  if(lumi_mask_cut){
+    cutFlow.Add("Lumi mask", [this](edm::Event const & event, pat::strbitset & ret){
+      if( ! lumiMask.Contains(event.id().run(), event.id().luminosityBlock()) ) return false;
+      PassCut(ret, cutLumiMask);
+      return true;
+    });
+  }
+
+  cutFlow.Add("Trigger", [this](edm::Event const & event, pat::strbitset & ret){
+    if( ! TriggerSelection(event) ) return false;
+    PassCut(ret, cutTrigger);
+    return true;
+  });
+
+  cutFlow.Add("Primary Vertex", [this](edm::Event const & event, pat::strbitset & ret){
+    if( ! PVSelection(event) ) return false;
+    PassCut(ret, cutPV);
+    return true;
+  });
+
+  cutFlow.Add("MET filters", [this](edm::Event const & event, pat::strbitset & ret){
+    if( ! METfilter(event) ) return false;
+    PassCut(ret, cutMETfilters);
+    return true;
+  });
+
+  // loose leptons are a subset of the input collections, so their sizes bound the loose lepton count
+  unsigned int minRawLeptons = 0;
+  if(minLooseLeptons_cut) minRawLeptons = (unsigned int)std::max(minLooseLeptons, 0);
+  if(minRawLeptons > 0){
+    cutFlow.Add("Raw lepton multiplicity", [this, minRawLeptons](edm::Event const & event, pat::strbitset & ret){
+      edm::Handle< pat::MuonCollection > muonsHandle;
+      event.getByToken(muonsToken, muonsHandle);
+      edm::Handle< pat::ElectronCollection > electronsHandle;
+      event.getByToken(electronsToken, electronsHandle);
+      return muonsHandle->size() + electronsHandle->size() >= minRawLeptons;
+    });
+  }
+
+  cutFlow.Add("Leptons", [this](edm::Event const & event, pat::strbitset & ret){
+    //Collect selected leptons
+    MuonSelection(event);
+    ElectronSelection(event);
+
+    if( ! LeptonsSelection(event, ret) ) return false;
+    PassCut(ret, stepLeptons); // keeping it simple for now
+    return true;
+  });
+
+  cutFlow.Add("Jets", [this](edm::Event const & event, pat::strbitset & ret){
+    //Collect jets
+    if( ! JetSelection(event, ret) ) return false;
+    PassCut(ret, stepJets); // keeping it simple for now
+
+    //AK8 jets are not used in the selection, they are built when a calculator asks for them
+    return true;
+  });
+
+  cutFlow.Add("MET", [this](edm::Event const & event, pat::strbitset & ret){
+    if( ! METSelection(event) ) return false;
+    PassCut(ret, cutMET);
+    return true;
+  });
 }
 
 bool MultiLepEventSelector::TriggerSelection(edm::Event const & event)
@@ -456,7 +545,7 @@ bool MultiLepEventSelector::TriggerSelection(edm::Event const & event)
 
 	bool passTrig = false;
 
-	if ( considerCut("Trigger") ) {
+	if ( ConsiderCut(cutTrigger) ) {
 
 		if(debug)std::cout << "\t" <<"TriggerSelection:"<< std::endl;
 
@@ -577,7 +666,7 @@ bool MultiLepEventSelector::PVSelection(edm::Event const & event)
     //_____ Primary Vertex cuts __________________________________
     //
     vSelPVs.clear();
-    if ( considerCut("Primary Vertex") ) {
+    if ( ConsiderCut(cutPV) ) {
 
     	if(debug)std::cout << "\t" <<"PVSelection:"<< std::endl;
 
@@ -612,7 +701,7 @@ bool MultiLepEventSelector::METfilter(edm::Event const & event)
 	//_____ MET Filters __________________________________
 	//
 	//
-	if (considerCut("MET filters")) {
+	if (ConsiderCut(cutMETfilters)) {
 
 	  if(debug)std::cout << "\t" <<"METFilterSelection:"<< std::endl;
 
@@ -1039,10 +1128,10 @@ bool MultiLepEventSelector::LeptonsSelection(edm::Event const & event, pat::strb
 	bool pass_minLeptons      = false;
 	bool pass_maxLeptons      = false;
 
-	if(considerCut("Min Loose Leptons")){
+	if(ConsiderCut(cutMinLooseLeptons)){
 		if ( nLooseLeps >= (unsigned int)minLooseLeptons){
 			pass_minLooseLeptons = true;
-			passCut(ret, "Min Loose Leptons");
+			PassCut(ret, cutMinLooseLeptons);
 			if(debug)std::cout << "\t\t\t" << "pass_minLooseLeptons"<<std::endl;
 		}
 		else{
@@ -1050,10 +1139,10 @@ bool MultiLepEventSelector::LeptonsSelection(edm::Event const & event, pat::strb
 		}
 	}
 
-	if(considerCut("Max Loose Leptons")){
+	if(ConsiderCut(cutMaxLooseLeptons)){
 		if ( nLooseLeps <= (unsigned int)maxLooseLeptons){
 			pass_maxLooseLeptons = true;
-			passCut(ret, "Max Loose Leptons");
+			PassCut(ret, cutMaxLooseLeptons);
 			if(debug)std::cout << "\t\t\t" << "pass_maxLooseLeptons"<<std::endl;
 		}
 		else{
@@ -1062,10 +1151,10 @@ bool MultiLepEventSelector::LeptonsSelection(edm::Event const & event, pat::strb
 	}
 
 
-	if(considerCut("Min Leptons")){
+	if(ConsiderCut(cutMinLeptons)){
 		if ( nLeps >= (unsigned int)minLeptons){
 			pass_minLeptons = true;
-			passCut(ret, "Min Leptons");
+			PassCut(ret, cutMinLeptons);
 			if(debug)std::cout << "\t\t\t" << "pass_minLeptons"<<std::endl;
 		}
 		else{
@@ -1073,10 +1162,10 @@ bool MultiLepEventSelector::LeptonsSelection(edm::Event const & event, pat::strb
 		}
 	}
 
-	if(considerCut("Max Leptons")){
+	if(ConsiderCut(cutMaxLeptons)){
 		if ( nLeps <= (unsigned int)maxLeptons){
 			pass_maxLeptons = true;
-			passCut(ret, "Max Leptons");
+			PassCut(ret, cutMaxLeptons);
 			if(debug)std::cout << "\t\t\t" << "pass_maxLeptons"<<std::endl;
 		}
 		else{
@@ -1084,10 +1173,10 @@ bool MultiLepEventSelector::LeptonsSelection(edm::Event const & event, pat::strb
 		}
 	}
 
-	if(ignoreCut("Min Loose Leptons")) pass_minLooseLeptons = true;
-	if(ignoreCut("Max Loose Leptons")) pass_maxLooseLeptons = true;
-	if(ignoreCut("Min Leptons")) pass_minLeptons = true;
-	if(ignoreCut("Max Leptons")) pass_maxLeptons = true;
+	if(IgnoreCut(cutMinLooseLeptons)) pass_minLooseLeptons = true;
+	if(IgnoreCut(cutMaxLooseLeptons)) pass_maxLooseLeptons = true;
+	if(IgnoreCut(cutMinLeptons)) pass_minLeptons = true;
+	if(IgnoreCut(cutMaxLeptons)) pass_maxLeptons = true;
 
 	if( pass_minLooseLeptons && pass_maxLooseLeptons && pass_minLeptons && pass_maxLeptons) pass=true;
 
@@ -1118,7 +1207,7 @@ bool MultiLepEventSelector::JetSelection(edm::Event const & event, pat::strbitse
 
   vAllJets.clear();
   vSelJets.clear();
-  vSelCorrJets.clear();
+  vSelCorrJetRecords.clear();
 /*  mvCorrJets_jesup.clear();
   mvCorrJets_jesdn.clear();
   mvCorrJets_jerup.clear();
@@ -1158,8 +1247,9 @@ bool MultiLepEventSelector::JetSelection(edm::Event const & event, pat::strbitse
     TLorentzVector jetP4_jerup;
     TLorentzVector jetP4_jerdn;
 */
-    pat::Jet tmpJet = _ijet->correctedJet(0);
-    pat::Jet corrJet = *_ijet;
+    // raw four-momentum; lepton constituents are subtracted from cleanedP4
+    const reco::Candidate::LorentzVector rawP4 = _ijet->jecFactor(0)*_ijet->p4();
+    reco::Candidate::LorentzVector cleanedP4 = rawP4;
 
 
     if ( doLepJetCleaning ){
@@ -1182,17 +1272,8 @@ bool MultiLepEventSelector::JetSelection(edm::Event const & event, pat::strbitse
 		  for ( std::vector<edm::Ptr<reco::Candidate> >::const_iterator _i_const = _ijet_consts.begin(); _i_const != _ijet_consts.end(); ++_i_const){
 			for (unsigned int muI = 0; muI < muDaughters.size(); muI++) {
 			  if ( (*_i_const).key() == muDaughters[muI].key() ) {
-				tmpJet.setP4( tmpJet.p4() - muDaughters[muI]->p4() );
-				if (debug) std::cout << "  Cleaned Jet : pT = " << tmpJet.pt() << " eta = " << tmpJet.eta() << " phi = " << tmpJet.phi() << std::endl;
-				jetP4 = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet, syst); //THIS SEEMS REDUNDANT WITH correctJetReturnPatJet METHOD, CAN CALCULATE P4 FROM OUTPUT OF correctJetReturnPatJet RATHER THAN DOING EXACTLY EVERYTHING correctJetReturnPatJet IS DOING. FIX!!!! -- MAR 15,2019
-/*				if (mbPar["doAllJetSyst"]) {
-				  jetP4_jesup = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,1);
-				  jetP4_jesdn = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,2);
-				  jetP4_jerup = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,3);
-				  jetP4_jerdn = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,4);
-				}*/
-				corrJet = JetMETCorr.correctJetReturnPatJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet, syst); //THIS SEEMS REDUNDANT WITH correctJet METHOD ! FIX !!!
-				if (debug) std::cout << "Corrected Jet : pT = " << jetP4.Pt() << " eta = " << jetP4.Eta() << " phi = " << jetP4.Phi() << std::endl;
+				cleanedP4 -= muDaughters[muI]->p4();
+				if (debug) std::cout << "  Cleaned Jet : pT = " << cleanedP4.pt() << " eta = " << cleanedP4.eta() << " phi = " << cleanedP4.phi() << std::endl;
 				_cleaned = true;
 				muDaughters.erase( muDaughters.begin()+muI );
 				break;
@@ -1212,23 +1293,14 @@ bool MultiLepEventSelector::JetSelection(edm::Event const & event, pat::strbitse
 		  }
 		  if (debug) {
 			std::cout << "     Electron : pT = " << cleaningElectrons[iel]->pt() << " eta = " << cleaningElectrons[iel]->eta() << " phi = " << cleaningElectrons[iel]->phi() << std::endl;
-			std::cout << "      Raw Jet : pT = " << _ijet->correctedJet(0).pt() << " eta = " << _ijet->correctedJet(0).eta() << " phi = " << _ijet->correctedJet(0).phi() << std::endl;
+			std::cout << "      Raw Jet : pT = " << rawP4.pt() << " eta = " << rawP4.eta() << " phi = " << rawP4.phi() << std::endl;
 		  }
 		  const std::vector<edm::Ptr<reco::Candidate> > _ijet_consts = _ijet->daughterPtrVector();
 		  for ( std::vector<edm::Ptr<reco::Candidate> >::const_iterator _i_const = _ijet_consts.begin(); _i_const != _ijet_consts.end(); ++_i_const){
 			for (unsigned int elI = 0; elI < elDaughters.size(); elI++) {
 			  if ( (*_i_const).key() == elDaughters[elI].key() ) {
-				tmpJet.setP4( tmpJet.p4() - elDaughters[elI]->p4() );
-				if (debug) std::cout << "  Cleaned Jet : pT = " << tmpJet.pt() << " eta = " << tmpJet.eta() << " phi = " << tmpJet.phi() << std::endl;
-				jetP4 = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet, syst); //THIS SEEMS REDUNDANT WITH correctJetReturnPatJet METHOD, CAN CALCULATE P4 FROM OUTPUT OF correctJetReturnPatJet RATHER THAN DOING EXACTLY EVERYTHING correctJetReturnPatJet IS DOING. FIX!!!! -- MAR 15,2019
-/*				if (mbPar["doAllJetSyst"]) {
-				  jetP4_jesup = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,1);
-				  jetP4_jesdn = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,2);
-				  jetP4_jerup = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,3);
-				  jetP4_jerdn = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet,4);
-				}*/
-				corrJet = JetMETCorr.correctJetReturnPatJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet, syst); //THIS SEEMS REDUNDANT WITH correctJet METHOD ! FIX!!!! -- MAR 15,2019
-				if (debug) std::cout << "Corrected Jet : pT = " << jetP4.Pt() << " eta = " << jetP4.Eta() << " phi = " << jetP4.Phi() << std::endl;
+				cleanedP4 -= elDaughters[elI]->p4();
+				if (debug) std::cout << "  Cleaned Jet : pT = " << cleanedP4.pt() << " eta = " << cleanedP4.eta() << " phi = " << cleanedP4.phi() << std::endl;
 				_cleaned = true;
 				elDaughters.erase( elDaughters.begin()+elI );
 				break;
@@ -1239,46 +1311,42 @@ bool MultiLepEventSelector::JetSelection(edm::Event const & event, pat::strbitse
       }
     }
 
-    if (!_cleaned) {
-      jetP4 = JetMETCorr.correctJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet, syst);
-/*      if (mbPar["doAllJetSyst"]) {
-		jetP4_jesup = JetMETCorr.correctJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet,1);
-		jetP4_jesdn = JetMETCorr.correctJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet,2);
-		jetP4_jerup = JetMETCorr.correctJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet,3);
-		jetP4_jerdn = JetMETCorr.correctJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet,4);
-      }*/
-      corrJet = JetMETCorr.correctJetReturnPatJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet, syst);
-    }
+    // correct once, keeping only the record
+    CorrectedJet record = JetMETCorr.correctJetRecord(*_ijet, _n_jets, cleanedP4, _cleaned, event, rhoJetsToken, isAK8, reCorrectJet, syst);
+    jetP4.SetPtEtaPhiM(record.p4.pt(), record.p4.eta(), record.p4.phi(), record.p4.mass());
+    if (debug && _cleaned) std::cout << "Corrected Jet : pT = " << jetP4.Pt() << " eta = " << jetP4.Eta() << " phi = " << jetP4.Phi() << std::endl;
 
     _isTagged = btagSfUtil.isJetTagged(*_ijet, jetP4, event, isMc);
 
     // jet cuts  //NOTE: THIS IDEALLY SHOULDN'T BE HARD CODED -- Mar 13, 2019
+    // energy fractions and multiplicities do not depend on the JEC level, only eta is taken from the raw jet
+    const double rawEta = rawP4.eta();
     while(1){
 
       // PF Jet ID
-      if (fabs(_ijet->correctedJet(0).eta()) < 2.4 &&
-	  _ijet->correctedJet(0).neutralHadronEnergyFraction() < 0.90 &&
-	  _ijet->correctedJet(0).neutralEmEnergyFraction() < 0.90 &&
-	  _ijet->correctedJet(0).chargedMultiplicity()+_ijet->correctedJet(0).neutralMultiplicity() > 1 &&
-	  _ijet->correctedJet(0).chargedHadronEnergyFraction() > 0 &&
-	  _ijet->correctedJet(0).chargedMultiplicity() > 0
+      if (fabs(rawEta) < 2.4 &&
+	  _ijet->neutralHadronEnergyFraction() < 0.90 &&
+	  _ijet->neutralEmEnergyFraction() < 0.90 &&
+	  _ijet->chargedMultiplicity()+_ijet->neutralMultiplicity() > 1 &&
+	  _ijet->chargedHadronEnergyFraction() > 0 &&
+	  _ijet->chargedMultiplicity() > 0
 	  ){ }
-      else if (fabs(_ijet->correctedJet(0).eta()) >= 2.4 &&
-	       fabs(_ijet->correctedJet(0).eta()) < 2.7 &&
-	       _ijet->correctedJet(0).neutralHadronEnergyFraction() < 0.90 &&
-	       _ijet->correctedJet(0).neutralEmEnergyFraction() < 0.90 &&
-	       _ijet->correctedJet(0).chargedMultiplicity()+_ijet->correctedJet(0).neutralMultiplicity() > 1
+      else if (fabs(rawEta) >= 2.4 &&
+	       fabs(rawEta) < 2.7 &&
+	       _ijet->neutralHadronEnergyFraction() < 0.90 &&
+	       _ijet->neutralEmEnergyFraction() < 0.90 &&
+	       _ijet->chargedMultiplicity()+_ijet->neutralMultiplicity() > 1
 	       ){ }
-      else if (fabs(_ijet->correctedJet(0).eta()) >= 2.7 &&
-	       fabs(_ijet->correctedJet(0).eta()) < 3.0 &&
-	       _ijet->correctedJet(0).neutralEmEnergyFraction() > 0.02 &&
-	       _ijet->correctedJet(0).neutralEmEnergyFraction() < 0.99 &&
-	       _ijet->correctedJet(0).neutralMultiplicity() > 2
+      else if (fabs(rawEta) >= 2.7 &&
+	       fabs(rawEta) < 3.0 &&
+	       _ijet->neutralEmEnergyFraction() > 0.02 &&
+	       _ijet->neutralEmEnergyFraction() < 0.99 &&
+	       _ijet->neutralMultiplicity() > 2
 	       ){ }
-      else if (fabs(_ijet->correctedJet(0).eta()) >= 3.0 &&
-	       _ijet->correctedJet(0).neutralEmEnergyFraction() < 0.9 &&
-	       _ijet->correctedJet(0).neutralHadronEnergyFraction() > 0.02 &&
-	       _ijet->correctedJet(0).neutralMultiplicity() > 10
+      else if (fabs(rawEta) >= 3.0 &&
+	       _ijet->neutralEmEnergyFraction() < 0.9 &&
+	       _ijet->neutralHadronEnergyFraction() > 0.02 &&
+	       _ijet->neutralMultiplicity() > 10
 	       ){ }
       else break; // fail
 
@@ -1305,7 +1373,7 @@ bool MultiLepEventSelector::JetSelection(edm::Event const & event, pat::strbitse
       // save all the good jets
       ++_n_good_jets;
       vSelJets.push_back(edm::Ptr<pat::Jet>( jetsHandle, _n_jets));
-      vSelCorrJets.push_back(corrJet);
+      vSelCorrJetRecords.push_back(record);
 /*      if (mbPar["doAllJetSyst"]) {
 		mvCorrJets_jesup.push_back(jetP4_jesup);
 		mvCorrJets_jesdn.push_back(jetP4_jesdn);
@@ -1346,13 +1414,13 @@ bool MultiLepEventSelector::JetSelection(edm::Event const & event, pat::strbitse
 
 	  if ( jet_cuts ) {
 
-		  if ( ignoreCut("Min jet multiplicity") || _n_good_jets >= cut("Min jet multiplicity",int()) ) passCut(ret, "Min jet multiplicity");
+		  if ( IgnoreCut(cutMinJets) || _n_good_jets >= cut(CutIndex(cutMinJets),int()) ) PassCut(ret, cutMinJets);
 		  else break;
 
-		  if ( ignoreCut("Max jet multiplicity") || _n_good_jets <= cut("Max jet multiplicity",int()) ) passCut(ret, "Max jet multiplicity");
+		  if ( IgnoreCut(cutMaxJets) || _n_good_jets <= cut(CutIndex(cutMaxJets),int()) ) PassCut(ret, cutMaxJets);
 		  else break;
 
-		  if ( ignoreCut("Leading jet pt") ||  _leading_jet_pt >= cut("Leading jet pt",double()) ) passCut(ret, "Leading jet pt");
+		  if ( IgnoreCut(cutLeadingJetPt) ||  _leading_jet_pt >= cut(CutIndex(cutLeadingJetPt),double()) ) PassCut(ret, cutLeadingJetPt);
 		  else break;
 
 		  if(debug) std::cout << "\t\t\t" << "pass_jet"<<std::endl;
@@ -1401,15 +1469,16 @@ void MultiLepEventSelector::AK8JetSelection(edm::Event const & event)
   for (std::vector<pat::Jet>::const_iterator _ijet = AK8jetsHandle->begin();_ijet != AK8jetsHandle->end(); ++_ijet){
 
     if(_ijet->pt() < 170) continue;
-    if(_ijet->correctedJet(0).pt() < 170) continue;
+    // raw four-momentum; lepton constituents are subtracted from cleanedP4
+    const reco::Candidate::LorentzVector rawP4 = _ijet->jecFactor(0)*_ijet->p4();
+    if(rawP4.pt() < 170) continue;
 
     bool _pass = false;
     bool _cleaned = false;
 
     TLorentzVector jetP4;
 
-    pat::Jet tmpJet = _ijet->correctedJet(0);
-    pat::Jet corrJet = *_ijet;
+    reco::Candidate::LorentzVector cleanedP4 = rawP4;
 
     if ( doLepJetCleaning){
       if (debug) std::cout << " AK8 LepJetCleaning: Checking Overlap" << std::endl;
@@ -1431,11 +1500,8 @@ void MultiLepEventSelector::AK8JetSelection(edm::Event const & event)
 		  for ( std::vector<edm::Ptr<reco::Candidate> >::const_iterator _i_const = _ijet_consts.begin(); _i_const != _ijet_consts.end(); ++_i_const){
 			for (unsigned int muI = 0; muI < muDaughters.size(); muI++) {
 			  if ( (*_i_const).key() == muDaughters[muI].key() ) {
-				tmpJet.setP4( tmpJet.p4() - muDaughters[muI]->p4() );
-				if (debug) std::cout << "  Cleaned Jet : pT = " << tmpJet.pt() << " eta = " << tmpJet.eta() << " phi = " << tmpJet.phi() << " mass = " << tmpJet.mass() << std::endl;
-				jetP4 = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet);
-				corrJet = JetMETCorr.correctJetReturnPatJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet);
-				if (debug) std::cout << "Corrected Jet : pT = " << jetP4.Pt() << " eta = " << jetP4.Eta() << " phi = " << jetP4.Phi() << " mass = " << jetP4.M() << std::endl;
+				cleanedP4 -= muDaughters[muI]->p4();
+				if (debug) std::cout << "  Cleaned Jet : pT = " << cleanedP4.pt() << " eta = " << cleanedP4.eta() << " phi = " << cleanedP4.phi() << " mass = " << cleanedP4.mass() << std::endl;
 				_cleaned = true;
 				muDaughters.erase( muDaughters.begin()+muI );
 				break;
@@ -1455,17 +1521,14 @@ void MultiLepEventSelector::AK8JetSelection(edm::Event const & event)
 		  }
 		  if (debug) {
 			std::cout << "     Electron : pT = " << cleaningElectrons[iel]->pt() << " eta = " << cleaningElectrons[iel]->eta() << " phi = " << cleaningElectrons[iel]->phi() << " mass = " << cleaningElectrons[iel]->mass() << std::endl;
-			std::cout << "      Raw Jet : pT = " << _ijet->correctedJet(0).pt() << " eta = " << _ijet->correctedJet(0).eta() << " phi = " << _ijet->correctedJet(0).phi() << " mass = " << _ijet->correctedJet(0).mass() << std::endl;
+			std::cout << "      Raw Jet : pT = " << rawP4.pt() << " eta = " << rawP4.eta() << " phi = " << rawP4.phi() << " mass = " << rawP4.mass() << std::endl;
 		  }
 		  const std::vector<edm::Ptr<reco::Candidate> > _ijet_consts = _ijet->daughterPtrVector();
 		  for ( std::vector<edm::Ptr<reco::Candidate> >::const_iterator _i_const = _ijet_consts.begin(); _i_const != _ijet_consts.end(); ++_i_const){
 			for (unsigned int elI = 0; elI < elDaughters.size(); elI++) {
 			  if ( (*_i_const).key() == elDaughters[elI].key() ) {
-				tmpJet.setP4( tmpJet.p4() - elDaughters[elI]->p4() );
-				if (debug) std::cout << "  Cleaned Jet : pT = " << tmpJet.pt() << " eta = " << tmpJet.eta() << " phi = " << tmpJet.phi() << " mass = " << tmpJet.mass() << std::endl;
-				jetP4 = JetMETCorr.correctJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet);
-				corrJet = JetMETCorr.correctJetReturnPatJet(tmpJet, event, rhoJetsToken, isAK8, reCorrectJet);
-				if (debug) std::cout << "Corrected Jet : pT = " << jetP4.Pt() << " eta = " << jetP4.Eta() << " phi = " << jetP4.Phi() << " mass = " << jetP4.M() << std::endl;
+				cleanedP4 -= elDaughters[elI]->p4();
+				if (debug) std::cout << "  Cleaned Jet : pT = " << cleanedP4.pt() << " eta = " << cleanedP4.eta() << " phi = " << cleanedP4.phi() << " mass = " << cleanedP4.mass() << std::endl;
 				_cleaned = true;
 				elDaughters.erase( elDaughters.begin()+elI );
 				break;
@@ -1476,41 +1539,43 @@ void MultiLepEventSelector::AK8JetSelection(edm::Event const & event)
       }
     }
 
-    if (!_cleaned) {
-      jetP4 = JetMETCorr.correctJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet);
-      corrJet = JetMETCorr.correctJetReturnPatJet(*_ijet, event, rhoJetsToken, isAK8, reCorrectJet);
-    }
+    // correct once; the pat::Jet copy is only made for jets passing the selection
+    CorrectedJet record = JetMETCorr.correctJetRecord(*_ijet, _ijet - AK8jetsHandle->begin(), cleanedP4, _cleaned, event, rhoJetsToken, isAK8, reCorrectJet);
+    jetP4.SetPtEtaPhiM(record.p4.pt(), record.p4.eta(), record.p4.phi(), record.p4.mass());
+    if (debug && _cleaned) std::cout << "Corrected Jet : pT = " << jetP4.Pt() << " eta = " << jetP4.Eta() << " phi = " << jetP4.Phi() << " mass = " << jetP4.M() << std::endl;
 
     // jet cuts //NOTE: THIS IDEALLY SHOULDN'T BE HARD CODED -- Mar 14, 2019
+    // energy fractions and multiplicities do not depend on the JEC level, only eta is taken from the raw jet
+    const double rawEta = rawP4.eta();
     while(1){
 
       // PF Jet ID
-      if (fabs(_ijet->correctedJet(0).eta()) < 2.4 &&
-	  _ijet->correctedJet(0).neutralHadronEnergyFraction() < 0.90 &&
-	  _ijet->correctedJet(0).neutralEmEnergyFraction() < 0.90 &&
+      if (fabs(rawEta) < 2.4 &&
+	  _ijet->neutralHadronEnergyFraction() < 0.90 &&
+	  _ijet->neutralEmEnergyFraction() < 0.90 &&
 	  //_ijet->userFloat("patPuppiJetSpecificProducer:puppiMultiplicity") > 1 &&
-	  _ijet->correctedJet(0).chargedMultiplicity()+_ijet->correctedJet(0).neutralMultiplicity() > 1 &&
-	  _ijet->correctedJet(0).chargedHadronEnergyFraction() > 0 &&
-	  _ijet->correctedJet(0).chargedMultiplicity() > 0
+	  _ijet->chargedMultiplicity()+_ijet->neutralMultiplicity() > 1 &&
+	  _ijet->chargedHadronEnergyFraction() > 0 &&
+	  _ijet->chargedMultiplicity() > 0
 	  ){ }
-      else if (fabs(_ijet->correctedJet(0).eta()) >= 2.4 &&
-	       fabs(_ijet->correctedJet(0).eta()) < 2.7 &&
-	       _ijet->correctedJet(0).neutralHadronEnergyFraction() < 0.90 &&
-	       _ijet->correctedJet(0).neutralEmEnergyFraction() < 0.90 &&
+      else if (fabs(rawEta) >= 2.4 &&
+	       fabs(rawEta) < 2.7 &&
+	       _ijet->neutralHadronEnergyFraction() < 0.90 &&
+	       _ijet->neutralEmEnergyFraction() < 0.90 &&
 	       //_ijet->userFloat("patPuppiJetSpecificProducer:puppiMultiplicity") > 1
-	       _ijet->correctedJet(0).chargedMultiplicity()+_ijet->correctedJet(0).neutralMultiplicity() > 1
+	       _ijet->chargedMultiplicity()+_ijet->neutralMultiplicity() > 1
 	       ){ }
-      else if (fabs(_ijet->correctedJet(0).eta()) >= 2.7 &&
-	       fabs(_ijet->correctedJet(0).eta()) < 3.0 &&
-	       _ijet->correctedJet(0).neutralHadronEnergyFraction() < 0.99
+      else if (fabs(rawEta) >= 2.7 &&
+	       fabs(rawEta) < 3.0 &&
+	       _ijet->neutralHadronEnergyFraction() < 0.99
 	       ){ }
-      else if (fabs(_ijet->correctedJet(0).eta()) >= 3.0 &&
-	       _ijet->correctedJet(0).neutralEmEnergyFraction() < 0.9 &&
-	       _ijet->correctedJet(0).neutralHadronEnergyFraction() > 0.02 &&
+      else if (fabs(rawEta) >= 3.0 &&
+	       _ijet->neutralEmEnergyFraction() < 0.9 &&
+	       _ijet->neutralHadronEnergyFraction() > 0.02 &&
 	       //_ijet->userFloat("patPuppiJetSpecificProducer:neutralPuppiMultiplicity") > 2 &&
 	       //_ijet->userFloat("patPuppiJetSpecificProducer:neutralPuppiMultiplicity") < 15
-	       _ijet->correctedJet(0).neutralMultiplicity() > 2 &&
-	       _ijet->correctedJet(0).neutralMultiplicity() < 15
+	       _ijet->neutralMultiplicity() > 2 &&
+	       _ijet->neutralMultiplicity() < 15
 	       ){ }
       else break; // fail
 
@@ -1536,7 +1601,7 @@ void MultiLepEventSelector::AK8JetSelection(edm::Event const & event)
 
       // save all the good jets
       ++_n_good_jets_AK8;
-      vSelCorrJets_AK8.push_back(corrJet);
+      vSelCorrJets_AK8.push_back(CorrJetCopy(*_ijet, record, reCorrectJet));
 
     }
 
@@ -1544,13 +1609,38 @@ void MultiLepEventSelector::AK8JetSelection(edm::Event const & event)
 
   } // end of loop over AK8 jets
 
+  mAK8Features.Reset(event, vSelCorrJets_AK8);
+  SetBuilt(kSelCorrJetsAK8);
+
 
 }
 
-bool MultiLepEventSelector::METSelection(edm::Event const & event)
+void MultiLepEventSelector::BuildCollection(Collection collection)
 {
+  if (collection == kSelCorrJets) SelCorrJetCopies();
+  else if (collection == kSelCorrJetsAK8) AK8JetSelection(*mpEvent);
+  else if (collection == kCorrectedMet) METCorrection(*mpEvent);
+}
 
-	bool pass = false;
+pat::Jet MultiLepEventSelector::CorrJetCopy(const pat::Jet & jet, CorrectedJet const & record, bool reCorrectJet)
+{
+  // same content as the jet returned by JetMETCorrHelper::correctJetReturnPatJet
+  pat::Jet corrJet = (reCorrectJet || record.cleaned) ? jet.correctedJet(0) : jet;
+  corrJet.setP4(record.p4);
+  return corrJet;
+}
+
+void MultiLepEventSelector::SelCorrJetCopies()
+{
+  vSelCorrJets.clear();
+  vSelCorrJets.reserve(vSelCorrJetRecords.size());
+  for (unsigned int ijet = 0; ijet < vSelCorrJetRecords.size(); ijet++){
+    vSelCorrJets.push_back(CorrJetCopy(*vSelJets[ijet], vSelCorrJetRecords[ijet], doNewJEC));
+  }
+}
+
+void MultiLepEventSelector::METCorrection(edm::Event const & event)
+{
 
 	//for jet correction
 	bool reCorrectJet = doNewJEC;
@@ -1561,28 +1651,44 @@ bool MultiLepEventSelector::METSelection(edm::Event const & event)
 	else if (JERdown){syst=4;}
 	else syst = 0; //nominal
 
+	edm::Handle<std::vector<pat::MET> > mhMet;
+	event.getByToken( METtoken, mhMet );
+	pMet = edm::Ptr<pat::MET>( mhMet, 0);
+
+	//save to EventSelector object variable.
+	correctedMET_p4 = TLorentzVector();
+	mType1MET.Reset(reCorrectJet);
+	if ( pMet.isNonnull() && pMet.isAvailable() ) {
+	  pat::MET const & met = mhMet->at(0);
+	  // every jet corrected once for all variations, the calculators derive the other MET flavours from the same deltas
+	  JetMETCorr.correctMetType1(event,rhoJetsToken,vAllJets,reCorrectJet,syst,doAllJetSyst,mType1MET);
+	  correctedMET_p4 = mType1MET.Apply(met,syst);
+	}
+
+	SetBuilt(kCorrectedMet);
+
+}
+
+bool MultiLepEventSelector::METSelection(edm::Event const & event)
+{
+
+	bool pass = false;
 
 	//
 	//_____ MET cuts __________________________________
 	//
 	//
-	if (considerCut("MET")) {
+	if (ConsiderCut(cutMET)) {
 
 	  if (debug) std::cout<<"\t" <<"MET Selection:"<< std::endl;
 
-	  edm::Handle<std::vector<pat::MET> > mhMet;
-	  event.getByToken( METtoken, mhMet );
-	  pMet = edm::Ptr<pat::MET>( mhMet, 0);
+	  METCorrection(event);
 
 	  // pfMet
 	  bool passMinMET = false;
 	  bool passMaxMET = false;
 	  if ( pMet.isNonnull() && pMet.isAvailable() ) {
-	    pat::MET const & met = mhMet->at(0);
-	    TLorentzVector corrMET = JetMETCorr.correctMet(met,event,rhoJetsToken,vAllJets,reCorrectJet,syst);
-
-	    //save to EventSelector object variable.
-	    correctedMET_p4 = corrMET;
+	    TLorentzVector const & corrMET = correctedMET_p4;
 
 	    if (debug) std::cout<<"\t\t" <<"MET = " << corrMET.Pt()<< std::endl;
 
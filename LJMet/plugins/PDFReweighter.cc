@@ -0,0 +1,263 @@
+#include "FWLJMET/LJMet/interface/PDFReweighter.h"
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/Version.h"
+#include "LHAPDF/PDFSet.h"
+
+// the per-flavour KnotArray1F subgrids were replaced by a single KnotArray in LHAPDF 6.3
+#if LHAPDF_VERSION_CODE < 60300
+#define PDFREWEIGHTER_BATCHED
+#include "LHAPDF/GridPDF.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+
+// Hermite cubic on [0,1], as in LHAPDF's LogBicubicInterpolator
+static inline double interpolateCubic(double t, double vl, double vdl, double vh, double vdh)
+{
+    const double t2 = t*t;
+    const double t3 = t2*t;
+    return (2*t3 - 3*t2 + 1)*vl + (t3 - 2*t2 + t)*vdl + (-2*t3 + 3*t2)*vh + (t3 - t2)*vdh;
+}
+
+
+// Index of the knot below v, as KnotArray1F::ixbelow / iq2below
+static inline size_t knotBelow(std::vector<double> const & knots, double v)
+{
+    size_t i = std::upper_bound(knots.begin(), knots.end(), v) - knots.begin();
+    if(i == knots.size()) i -= 1;
+    return i - 1;
+}
+
+
+PDFReweighter::PDFReweighter():
+    mLegend("\t[PDFReweighter]: "),
+    mpBase(0),
+    mBatched(false)
+{
+}
+
+
+PDFReweighter::~PDFReweighter()
+{
+    clear();
+}
+
+
+void PDFReweighter::clear()
+{
+    delete mpBase;
+    mpBase = 0;
+    for(auto member : mvMembers) delete member;
+    mvMembers.clear();
+    mvSubgrids.clear();
+    mvForcePositive.clear();
+    mBatched = false;
+}
+
+
+void PDFReweighter::Initialize(std::string const & basePDFname, std::string const & newPDFname)
+{
+    clear();
+
+    std::cout << mLegend << "Loading base PDF " << basePDFname << " (member 0) and all members of " << newPDFname << std::endl;
+
+    mpBase = LHAPDF::mkPDF(basePDFname, 0);
+
+    const LHAPDF::PDFSet newset(newPDFname);
+    mvMembers = newset.mkPDFs();
+
+    std::cout << mLegend << "Loaded " << mvMembers.size() << " members" << std::endl;
+
+    mBatched = buildGrids();
+    if(!mBatched){
+        mvSubgrids.clear();
+        std::cout << mLegend << "Members are not log-bicubic grids on common knots, evaluating member by member" << std::endl;
+    }
+}
+
+
+bool PDFReweighter::buildGrids()
+{
+    mvSubgrids.clear();
+    mvForcePositive.clear();
+
+#ifndef PDFREWEIGHTER_BATCHED
+    return false;
+#else
+    std::vector<LHAPDF::GridPDF const *> grids;
+    for(auto member : mvMembers){
+        LHAPDF::GridPDF const * grid = dynamic_cast<LHAPDF::GridPDF const *>(member);
+        if(!grid) return false;
+        if(grid->info().get_entry("Interpolator", "logcubic") != "logcubic") return false;
+        grids.push_back(grid);
+        mvForcePositive.push_back(grid->info().get_entry_as<int>("ForcePositive", 0));
+    }
+    if(grids.empty()) return false;
+
+    const size_t nMem = grids.size();
+    for(auto grid : grids){
+        if(grid->subgrids().size() != grids[0]->subgrids().size()) return false;
+    }
+
+    for(auto const & sub : grids[0]->subgrids()){
+        Subgrid subgrid;
+        subgrid.q2Low = sub.first;
+
+        for(int pid : grids[0]->flavors()){
+            if(!sub.second.has_pid(pid)) continue;
+
+            LHAPDF::KnotArray1F const & knots = sub.second.get_pid(pid);
+            FlavourGrid & flavour = subgrid.flavours[pid];
+            flavour.xs     = knots.xs();
+            flavour.logxs  = knots.logxs();
+            flavour.q2s    = knots.q2s();
+            flavour.logq2s = knots.logq2s();
+
+            // the bicubic stencil needs 4 knots in each direction (LHAPDF falls back to bilinear otherwise)
+            const size_t nx = flavour.xs.size();
+            const size_t nq = flavour.q2s.size();
+            if(nx < 4 || nq < 4) return false;
+
+            flavour.xf.resize(nx*nq*nMem);
+            for(size_t m = 0; m < nMem; m++){
+                auto found = grids[m]->subgrids().find(sub.first);
+                if(found == grids[m]->subgrids().end() || !found->second.has_pid(pid)) return false;
+
+                LHAPDF::KnotArray1F const & memberKnots = found->second.get_pid(pid);
+                if(memberKnots.xs() != flavour.xs || memberKnots.q2s() != flavour.q2s) return false;
+
+                for(size_t ix = 0; ix < nx; ix++){
+                    for(size_t iq2 = 0; iq2 < nq; iq2++){
+                        flavour.xf[(ix*nq + iq2)*nMem + m] = memberKnots.xf(ix, iq2);
+                    }
+                }
+            }
+        }
+        mvSubgrids.push_back(subgrid);
+    }
+
+    mvXf1.resize(nMem);
+    mvXf2.resize(nMem);
+    mvVll.resize(nMem);
+    mvVl.resize(nMem);
+    mvVh.resize(nMem);
+    mvVhh.resize(nMem);
+    return true;
+#endif
+}
+
+
+void PDFReweighter::cubicInX(FlavourGrid const & grid, size_t ix, size_t iq2, double tlogx, std::vector<double> & out) const
+{
+    const size_t nMem   = out.size();
+    const size_t nx     = grid.xs.size();
+    const size_t xStep  = grid.q2s.size()*nMem;
+
+    // knots ix-1 .. ix+2 at this iq2, members contiguous
+    double const * f0 = &grid.xf[(ix*grid.q2s.size() + iq2)*nMem];
+    double const * f1 = f0 + xStep;
+    double const * fl = ix > 0     ? f0 - xStep : 0;
+    double const * fh = ix + 2 < nx ? f1 + xStep : 0;
+
+    // d(xf)/dlogx at ix and ix+1: one-sided at the grid edges, central difference otherwise
+    const bool lowEdge  = (fl == 0);
+    const bool highEdge = (fh == 0);
+    const double dlogx_l = lowEdge  ? 1 : grid.logxs[ix]   - grid.logxs[ix-1];
+    const double dlogx_1 =                grid.logxs[ix+1] - grid.logxs[ix];
+    const double dlogx_h = highEdge ? 1 : grid.logxs[ix+2] - grid.logxs[ix+1];
+
+    for(size_t m = 0; m < nMem; m++){
+        const double d01  = (f1[m] - f0[m]) / dlogx_1;
+        const double ddx0 = lowEdge  ? d01 : ((f0[m] - fl[m]) / dlogx_l + d01) / 2.0;
+        const double ddx1 = highEdge ? d01 : (d01 + (fh[m] - f1[m]) / dlogx_h) / 2.0;
+        out[m] = interpolateCubic(tlogx, f0[m], ddx0*dlogx_1, f1[m], ddx1*dlogx_1);
+    }
+}
+
+
+bool PDFReweighter::sweep(int id, double x, double q2, std::vector<double> & xf)
+{
+    if(id == 0) id = 21;
+
+    // subgrid holding q2, as GridPDF::subgrid
+    auto sub = std::upper_bound(mvSubgrids.begin(), mvSubgrids.end(), q2,
+                                [](double q, Subgrid const & s){ return q < s.q2Low; });
+    if(sub == mvSubgrids.begin()) return false;
+    --sub;
+
+    auto found = sub->flavours.find(id);
+    if(found == sub->flavours.end()) return false;
+    FlavourGrid const & grid = found->second;
+
+    if(x < grid.xs.front() || x > grid.xs.back() || q2 < grid.q2s.front() || q2 > grid.q2s.back()) return false;
+
+    // the cell and interpolation parameters are common to all members
+    const size_t ix     = knotBelow(grid.xs, x);
+    const size_t iq2    = knotBelow(grid.q2s, q2);
+    const size_t iq2max = grid.q2s.size() - 1;
+
+    const double tlogx   = (std::log(x) - grid.logxs[ix]) / (grid.logxs[ix+1] - grid.logxs[ix]);
+    const double dlogq_0 = (iq2 != 0)        ? grid.logq2s[iq2]   - grid.logq2s[iq2-1] : -1;
+    const double dlogq_1 =                     grid.logq2s[iq2+1] - grid.logq2s[iq2];
+    const double dlogq_2 = (iq2+1 != iq2max) ? grid.logq2s[iq2+2] - grid.logq2s[iq2+1] : -1;
+    const double tlogq   = (std::log(q2) - grid.logq2s[iq2]) / dlogq_1;
+
+    // x interpolation on the Q2 knots of the stencil
+    cubicInX(grid, ix, iq2,   tlogx, mvVl);
+    cubicInX(grid, ix, iq2+1, tlogx, mvVh);
+    if(iq2 != 0)        cubicInX(grid, ix, iq2-1, tlogx, mvVll);
+    if(iq2+1 != iq2max) cubicInX(grid, ix, iq2+2, tlogx, mvVhh);
+
+    // then in Q2, with forward/backward differences at the subgrid edges
+    const size_t nMem = xf.size();
+    for(size_t m = 0; m < nMem; m++){
+        const double vl = mvVl[m];
+        const double vh = mvVh[m];
+        double vdl, vdh;
+        if(iq2 == 0){
+            vdl = vh - vl;
+            vdh = (vdl + (mvVhh[m] - vh)*dlogq_1/dlogq_2) / 2.0;
+        }
+        else if(iq2+1 == iq2max){
+            vdh = vh - vl;
+            vdl = (vdh + (vl - mvVll[m])*dlogq_1/dlogq_0) / 2.0;
+        }
+        else{
+            vdl = ((vh - vl) + (vl - mvVll[m])*dlogq_1/dlogq_0) / 2.0;
+            vdh = ((vh - vl) + (mvVhh[m] - vh)*dlogq_1/dlogq_2) / 2.0;
+        }
+
+        double value = interpolateCubic(tlogq, vl, vdl, vh, vdh);
+        if(mvForcePositive[m] == 1 && value < 0)          value = 0;
+        else if(mvForcePositive[m] == 2 && value < 1e-10) value = 1e-10;
+        xf[m] = value;
+    }
+    return true;
+}
+
+
+void PDFReweighter::Evaluate(int id1, double x1, int id2, double x2, double Q,
+                             std::vector<double> & weights, double & base)
+{
+    weights.clear();
+    base = 0;
+    if(!mpBase) return;
+
+    const double q2 = Q*Q;
+    base = mpBase->xfxQ2(id1, x1, q2) * mpBase->xfxQ2(id2, x2, q2);
+
+    if(mBatched && sweep(id1, x1, q2, mvXf1) && sweep(id2, x2, q2, mvXf2)){
+        weights.resize(mvMembers.size());
+        for(size_t m = 0; m < weights.size(); m++) weights[m] = mvXf1[m] * mvXf2[m] / base;
+        return;
+    }
+
+    // outside the grids, not a common log-bicubic set or LHAPDF >= 6.3: let LHAPDF handle each member
+    weights.reserve(mvMembers.size());
+    for(auto member : mvMembers){
+        weights.push_back(member->xfxQ2(id1, x1, q2) * member->xfxQ2(id2, x2, q2) / base);
+    }
+}
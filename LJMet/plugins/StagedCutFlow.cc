@@ -0,0 +1,39 @@
+#include "FWLJMET/LJMet/interface/StagedCutFlow.h"
+
+#include <iomanip>
+
+
+void StagedCutFlow::Add(std::string const & name, Stage stage)
+{
+    Entry entry = {name, stage, 0, 0, 0, 0};
+    if(mpProfiler) entry.timer = mpProfiler->Register(mGroup, name);
+    if(mpAllocProfiler) entry.allocProbe = mpAllocProfiler->Register(mGroup, name);
+    mvStages.push_back(entry);
+}
+
+
+bool StagedCutFlow::Run(edm::Event const & event, pat::strbitset & ret)
+{
+    for(auto & entry : mvStages){
+        entry.nSeen++;
+        bool passed;
+        {
+            LatencyProfiler::Scope scope(mpProfiler, entry.timer);
+            AllocationProfiler::Scope allocScope(mpAllocProfiler, entry.allocProbe);
+            passed = entry.stage(event, ret);
+        }
+        if(!passed) return false;
+        entry.nPassed++;
+    }
+    return true;
+}
+
+
+void StagedCutFlow::Print(std::ostream & out, std::string const & legend) const
+{
+    out << legend << "Selection stages (seen / passed):" << std::endl;
+    for(auto const & entry : mvStages){
+        out << legend << "  " << std::left << std::setw(28) << entry.name << std::right
+            << std::setw(12) << entry.nSeen << std::setw(12) << entry.nPassed << std::endl;
+    }
+}
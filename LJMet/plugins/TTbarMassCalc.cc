@@ -129,8 +129,10 @@ int TTbarMassCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * se
     edm::Handle<reco::GenParticleCollection> genParticles;
     if(event.getByToken(genParticlesToken, genParticles)){
 
-      // loop over all gen particles in event
-      for(size_t i = 0; i < genParticles->size(); i++){
+      const std::vector<unsigned int> & genTops = selector->GetGenParticleIndex(genParticles).WithAbsPdgId(6);
+
+      // loop over all gen tops in event
+      for(size_t i : genTops){
 	const reco::GenParticle &p = (*genParticles).at(i);
 	int id = p.pdgId();
 	
@@ -223,8 +225,8 @@ int TTbarMassCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * se
 	}
       }
 
-      // loop over all gen particles in event
-      for(size_t i = 0; i < genParticles->size(); i++){
+      // loop over all gen tops in event
+      for(size_t i : genTops){
 	const reco::GenParticle &p = (*genParticles).at(i);
 	int id = p.pdgId();
 	
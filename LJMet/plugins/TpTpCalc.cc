@@ -140,8 +140,11 @@ int TpTpCalc::AnalyzeEvent(edm::Event const & event, BaseEventSelector * selecto
     // Get the generated particle collection
     edm::Handle<reco::GenParticleCollection> genParticles;
     if(event.getByToken(genParticlesToken, genParticles)){
-      // loop over all gen particles in event
-      for(size_t i = 0; i < genParticles->size(); i++){
+      std::vector<unsigned int> candidates;
+      selector->GetGenParticleIndex(genParticles).SelectAbsPdgIds({8, 8000001, 8000002}, candidates);
+
+      // loop over the T', B' (and 8) gen particles in event
+      for(size_t i : candidates){
         const reco::GenParticle &p = (*genParticles).at(i);
         int id = p.pdgId();
 
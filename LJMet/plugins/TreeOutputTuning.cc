@@ -0,0 +1,163 @@
+#include "FWLJMET/LJMet/interface/TreeOutputTuning.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "TBranch.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+
+TreeOutputTuning::TreeOutputTuning():
+    mLegend("\t[TreeOutputTuning]: "),
+    mCompression(-1),
+    mAutoFlush(0),
+    mBasketSizeEvents(0),
+    mBasketSizeMin(16*1024),
+    mBasketSizeMax(4*1024*1024),
+    mbReport(false),
+    mbBasketsSized(false),
+    mFillSeconds(0)
+{
+}
+
+
+void TreeOutputTuning::Configure(edm::ParameterSet const & pset)
+{
+    std::string algorithm = pset.getUntrackedParameter<std::string>("compressionAlgorithm", "");
+    int level             = pset.getUntrackedParameter<int>("compressionLevel", -1);
+    mAutoFlush            = pset.getUntrackedParameter<long long>("autoFlush", 0);
+    mBasketSizeEvents     = pset.getUntrackedParameter<unsigned int>("basketSizeEvents", 0);
+    mBasketSizeMin        = pset.getUntrackedParameter<int>("basketSizeMin", mBasketSizeMin);
+    mBasketSizeMax        = pset.getUntrackedParameter<int>("basketSizeMax", mBasketSizeMax);
+    mbReport              = pset.getUntrackedParameter<bool>("report", false);
+
+    // ROOT::RCompressionSetting::EAlgorithm values; 0 is the global default
+    int code = 0;
+    if      (algorithm == "")     code = 0;
+    else if (algorithm == "ZLIB") code = 1;
+    else if (algorithm == "LZMA") code = 2;
+    else if (algorithm == "LZ4")  code = 4;
+    else if (algorithm == "ZSTD") code = 5;
+    else throw cms::Exception("InvalidInput") << "Unknown compression algorithm: " << algorithm << std::endl;
+
+    if (code > 0 && level < 0) level = 4; // ROOT's default level
+    if (level > 9) throw cms::Exception("InvalidInput") << "Compression level out of range: " << level << std::endl;
+    if (level >= 0) mCompression = 100*code + level;
+
+    if (mCompression >= 0) std::cout << mLegend << "compression " << (algorithm.empty() ? "default" : algorithm) << ", level " << level << std::endl;
+    if (mAutoFlush != 0) std::cout << mLegend << "auto-flush " << mAutoFlush << (mAutoFlush > 0 ? " entries" : " bytes") << std::endl;
+    if (mBasketSizeEvents > 0) std::cout << mLegend << "basket sizes from the first " << mBasketSizeEvents << " events, "
+                                         << mBasketSizeMin << " to " << mBasketSizeMax << " bytes" << std::endl;
+}
+
+
+void TreeOutputTuning::ApplyToTree(TTree * tree)
+{
+    if (mAutoFlush != 0) tree->SetAutoFlush(mAutoFlush);
+}
+
+
+void TreeOutputTuning::AddBranch(TTree * tree, std::string const & name, std::string const & group)
+{
+    Branch branch;
+    branch.name  = name;
+    branch.group = std::find(mvGroups.begin(), mvGroups.end(), group) - mvGroups.begin();
+    if (branch.group == (int)mvGroups.size()) mvGroups.push_back(group);
+    mvBranches.push_back(branch);
+
+    if (mCompression < 0) return;
+    TBranch * pBranch = tree->GetBranch(name.c_str());
+    if (pBranch) pBranch->SetCompressionSettings(mCompression);
+}
+
+
+void TreeOutputTuning::AfterFill(TTree * tree, std::chrono::steady_clock::duration fillTime)
+{
+    mFillSeconds += std::chrono::duration<double>(fillTime).count();
+
+    if (mbBasketsSized || mBasketSizeEvents == 0 || tree->GetEntries() < mBasketSizeEvents) return;
+    sizeBaskets(tree);
+    mbBasketsSized = true;
+}
+
+
+void TreeOutputTuning::sizeBaskets(TTree * tree)
+{
+    double nEntries = tree->GetEntries();
+
+    // uncompressed bytes per event, per group and over the tree
+    std::vector<double> groupBytes(mvGroups.size(), 0);
+    std::vector<int> groupBranches(mvGroups.size(), 0);
+    double treeBytes = 0;
+    for (auto const & branch : mvBranches){
+        TBranch * pBranch = tree->GetBranch(branch.name.c_str());
+        if (!pBranch) continue;
+        double bytes = pBranch->GetTotBytes("*")/nEntries;
+        groupBytes[branch.group] += bytes;
+        groupBranches[branch.group]++;
+        treeBytes += bytes;
+    }
+
+    // one basket per branch and cluster, for the average branch of the group
+    long long autoFlush = tree->GetAutoFlush();
+    double clusterEvents = nEntries;
+    if (autoFlush > 0) clusterEvents = autoFlush;
+    else if (autoFlush < 0 && treeBytes > 0) clusterEvents = -autoFlush/treeBytes;
+
+    std::vector<int> groupSize(mvGroups.size(), 0);
+    for (unsigned int group = 0; group < mvGroups.size(); group++){
+        if (groupBranches[group] == 0) continue;
+        double size = groupBytes[group]/groupBranches[group]*clusterEvents;
+        size = std::min(std::max(size, (double)mBasketSizeMin), (double)mBasketSizeMax);
+        groupSize[group] = ((int)size + 511)/512*512;
+
+        std::cout << mLegend << mvGroups[group] << ": " << groupBranches[group] << " branches, "
+                  << groupBytes[group]/groupBranches[group] << " bytes per event and branch, basket size " << groupSize[group] << std::endl;
+    }
+
+    for (auto const & branch : mvBranches){
+        TBranch * pBranch = tree->GetBranch(branch.name.c_str());
+        if (pBranch && groupSize[branch.group] > 0) pBranch->SetBasketSize(groupSize[branch.group]);
+    }
+}
+
+
+void TreeOutputTuning::Print(std::ostream & out, TTree * tree) const
+{
+    struct Bytes {
+        std::string name;
+        double tot;
+        double zip;
+    };
+
+    std::vector<Bytes> vBranches;
+    std::vector<Bytes> vGroups(mvGroups.size());
+    for (unsigned int group = 0; group < mvGroups.size(); group++) vGroups[group] = {mvGroups[group], 0, 0};
+    for (auto const & branch : mvBranches){
+        TBranch * pBranch = tree->GetBranch(branch.name.c_str());
+        if (!pBranch) continue;
+        Bytes bytes = {branch.name, (double)pBranch->GetTotBytes("*"), (double)pBranch->GetZipBytes("*")};
+        vBranches.push_back(bytes);
+        vGroups[branch.group].tot += bytes.tot;
+        vGroups[branch.group].zip += bytes.zip;
+    }
+    std::sort(vBranches.begin(), vBranches.end(), [](Bytes const & a, Bytes const & b){ return a.zip > b.zip; });
+
+    // baskets still in memory are only written when the file is closed, they are not in the compressed sizes
+    double tot = tree->GetTotBytes();
+    double zip = tree->GetZipBytes();
+    out << mLegend << "Output tree: " << tree->GetEntries() << " entries, " << tot/1e6 << " MB uncompressed, "
+        << zip/1e6 << " MB written, ratio " << (zip > 0 ? tot/zip : 0) << std::endl;
+    if (mFillSeconds > 0) out << mLegend << "TTree::Fill " << mFillSeconds << " s, " << tot/1e6/mFillSeconds << " MB/s uncompressed" << std::endl;
+
+    auto print = [&out, this](Bytes const & bytes){
+        char buff[1000];
+        sprintf(buff, "%-50s %10.3f MB %10.3f MB %8.2f", bytes.name.c_str(), bytes.tot/1e6, bytes.zip/1e6, bytes.zip > 0 ? bytes.tot/bytes.zip : 0.);
+        out << mLegend << buff << std::endl;
+    };
+
+    out << mLegend << "Per branch group (uncompressed / written / ratio):" << std::endl;
+    for (auto const & group : vGroups) print(group);
+    out << mLegend << "Per branch (uncompressed / written / ratio):" << std::endl;
+    for (auto const & branch : vBranches) print(branch);
+}
@@ -116,6 +116,9 @@ MultiLepSelector_cfg = cms.PSet(
 
             isMc  = cms.bool(isMC),
 
+            # Certified lumis, data only; empty keeps every lumi
+            lumiJSON = cms.untracked.string(''), # e.g. 'FWLJMET/LJMet/data/json/Cert_294927-306462_13TeV_PromptReco_Collisions17_JSON.txt'
+
             # Trigger cuts
             trigger_cut  = cms.bool(True),
             HLTcollection= cms.InputTag("TriggerResults","","HLT"),
@@ -327,6 +330,7 @@ MultiLepCalc_cfg = cms.PSet(
             OverrideLHEWeights = cms.bool(True),
             basePDFname        = cms.string('NNPDF31_nnlo_as_0118_nf_4'),
             newPDFname         = cms.string('NNPDF31_lo_as_0118'),
+            keepLHEWeightIds   = cms.untracked.vint32(), # inclusive [low, high] id pairs, e.g. (1001,1009, 2001,2102); empty keeps all
             keepPDGID          = cms.vuint32(1, 2, 3, 4, 5, 6, 21, 11, 12, 13, 14, 15, 16, 24),
             keepMomPDGID       = cms.vuint32(6, 24),
             keepPDGIDForce     = cms.vuint32(6,6),
@@ -409,6 +413,19 @@ process.ljmet = cms.EDAnalyzer(
 
         debug         = cms.bool(False),
         verbosity     = cms.int32(1),
+        profileTiming = cms.untracked.bool(False), # per-stage / per-calculator latency histograms in the Timing directory
+        profileAllocations = cms.untracked.bool(False), # per-stage / per-calculator heap use in the Allocations directory
+        treeOutput    = cms.untracked.PSet( # output tree I/O, see interface/TreeOutputTuning.h; empty keeps the ROOT defaults
+                        compressionAlgorithm = cms.untracked.string(''),   # ZLIB, LZMA, LZ4, ZSTD
+                        compressionLevel     = cms.untracked.int32(-1),
+                        autoFlush            = cms.untracked.int64(0),     # > 0 entries, < 0 bytes per cluster
+                        basketSizeEvents     = cms.untracked.uint32(0),    # size baskets per branch group after this many events
+                        report               = cms.untracked.bool(False),  # write throughput and compression per branch at EndJob
+                        asyncQueueDepth      = cms.untracked.uint32(0),    # > 0: TTree::Fill on a writer thread, this many events in flight; only if no other module writes a TTree to the TFileService file
+                        precision            = cms.untracked.VPSet(        # double branches stored as float, see interface/BranchPrecision.h, e.g.
+                        # cms.PSet(pattern = cms.untracked.string('theJetDaughter*'), mode = cms.untracked.string('mantissa'), bits = cms.untracked.int32(10)),
+                        ),
+        ),
         selector      = cms.string('MultiLepSelector'),
         include_calcs = cms.vstring(
                         'MultiLepCalc',
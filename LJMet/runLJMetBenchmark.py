@@ -0,0 +1,117 @@
+import FWCore.ParameterSet.Config as cms
+from FWCore.ParameterSet.VarParsing import VarParsing
+import os
+
+## Micro-benchmarks of the LJMet kernels (mini-isolation, jet corrections, b-tagging,
+## event content, BEST) on a locally cached MiniAOD file, no grid access needed:
+##   cmsRun runLJMetBenchmark.py inputFiles=file:/path/to/local.root maxEvents=200 isMC=1
+## Prints ns per call and calls per second at the end of the job; the per-call latency
+## histograms go to the Benchmark directory of the output file.
+## Standalone: only the services the benchmark uses, no GlobalTag or ESSources (the kernels
+## read their corrections from the text files below).
+
+options = VarParsing('analysis')
+options.register('isMC', True, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'MC (JEC uncertainty, JER smearing) or data (era JEC)')
+options.register('nRepeat', 100, VarParsing.multiplicity.singleton, VarParsing.varType.int, 'back-to-back calls per object')
+options.register('seed', 12345, VarParsing.multiplicity.singleton, VarParsing.varType.int, 'seed of the synthetic b-tag lookups')
+options.inputFiles = 'file:ljmet_benchmark_input.root'
+options.maxEvents = 200
+options.outputFile = 'ljmet_benchmark.root'
+options.parseArguments()
+
+relBase = os.environ['CMSSW_BASE']
+dataDir = relBase+'/src/FWLJMET/LJMet/data/'
+
+process = cms.Process("LJMETBENCHMARK")
+
+process.load("FWCore.MessageService.MessageLogger_cfi")
+process.MessageLogger.cerr.FwkReport.reportEvery = 100
+
+process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(options.maxEvents) )
+process.source = cms.Source("PoolSource", fileNames = cms.untracked.vstring(options.inputFiles))
+process.TFileService = cms.Service("TFileService", fileName = cms.string(options.outputFile))
+
+## Only the selector parameters read by LJMetBenchmark, JetMETCorrHelper and BTagSFUtil,
+## same values as runFWLJMet_multiLep.py
+BenchmarkSelector_cfg = cms.PSet(
+
+            debug  = cms.bool(False),
+
+            isMc  = cms.bool(options.isMC),
+
+            #Collections
+            jet_collection           = cms.InputTag('slimmedJets'),
+            AK8jet_collection        = cms.InputTag('slimmedJetsAK8'),
+            muonsCollection          = cms.InputTag("slimmedMuons"),
+            electronsCollection      = cms.InputTag("slimmedElectrons"),
+            PFparticlesCollection    = cms.InputTag("packedPFCandidates"),
+            rhoJetsInputTag          = cms.InputTag("fixedGridRhoFastjetAll"),
+            rhoJetsNCInputTag        = cms.InputTag("fixedGridRhoFastjetCentralNeutral",""),
+
+            #Jet corrections
+            doNewJEC                 = cms.bool(True),
+            JECup                    = cms.bool(False),
+            JECdown                  = cms.bool(False),
+            JERup                    = cms.bool(False),
+            JERdown                  = cms.bool(False),
+            JEC_txtfile              = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017_V32_MC_Uncertainty_AK4PFchs.txt'),
+            JERSF_txtfile            = cms.string(dataDir+'Fall17V3/Fall17_V3_MC_SF_AK4PFchs.txt'),
+            JER_txtfile              = cms.string(dataDir+'Fall17V3/Fall17_V3_MC_PtResolution_AK4PFchs.txt'),
+            JERAK8_txtfile           = cms.string(dataDir+'Fall17V3/Fall17_V3_MC_PtResolution_AK8PFPuppi.txt'),
+            MCL1JetPar               = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017_V32_MC_L1FastJet_AK4PFchs.txt'),
+            MCL2JetPar               = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017_V32_MC_L2Relative_AK4PFchs.txt'),
+            MCL3JetPar               = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017_V32_MC_L3Absolute_AK4PFchs.txt'),
+            MCL1JetParAK8            = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017_V32_MC_L1FastJet_AK8PFPuppi.txt'),
+            MCL2JetParAK8            = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017_V32_MC_L2Relative_AK8PFPuppi.txt'),
+            MCL3JetParAK8            = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017_V32_MC_L3Absolute_AK8PFPuppi.txt'),
+            DataL1JetPar             = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L1FastJet_AK4PFchs.txt'),
+            DataL2JetPar             = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L2Relative_AK4PFchs.txt'),
+            DataL3JetPar             = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L3Absolute_AK4PFchs.txt'),
+            DataResJetPar            = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L2L3Residual_AK4PFchs.txt'),
+            DataL1JetParAK8          = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L1FastJet_AK8PFPuppi.txt'),
+            DataL2JetParAK8          = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L2Relative_AK8PFPuppi.txt'),
+            DataL3JetParAK8          = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L3Absolute_AK8PFPuppi.txt'),
+            DataResJetParAK8         = cms.string(dataDir+'Fall17V32/Fall17_17Nov2017B_V32_DATA_L2L3Residual_AK8PFPuppi.txt'),
+
+            #Btag
+            btagOP                   = cms.string('MEDIUM'),
+            bdisc_min                = cms.double(0.4941), # THIS HAS TO MATCH btagOP !
+            applyBtagSF              = cms.bool(True),
+            DeepCSVfile              = cms.string(dataDir+'DeepCSV_94XSF_V3_B_F.csv'),
+            DeepCSVSubjetfile        = cms.string(dataDir+'subjet_DeepCSV_94XSF_V3_B_F.csv'),
+            BTagUncertUp             = cms.bool(False),
+            BTagUncertDown           = cms.bool(False),
+            MistagUncertUp           = cms.bool(False),
+            MistagUncertDown         = cms.bool(False),
+
+            )
+
+process.ljmetBenchmark = cms.EDAnalyzer(
+        'LJMetBenchmark',
+
+        debug        = cms.bool(False),
+        nRepeat      = cms.untracked.uint32(options.nRepeat),
+        nLookups     = cms.untracked.uint32(1000), # synthetic (pt, eta) points per event for the b-tag tables
+        nTreeEntries = cms.untracked.uint32(1000), # in-memory tree is reset after this many entries
+        seed         = cms.untracked.uint32(options.seed),
+        selector     = cms.string('BenchmarkSelector'),
+
+        BenchmarkSelector = BenchmarkSelector_cfg,
+)
+
+## BestCalc::execute is only benchmarked when the BEST network is available (same settings as the single-lepton job)
+if os.path.exists(dataDir+'BEST_mlp.json'):
+    process.ljmetBenchmark.BestCalc = cms.PSet(
+        dnnFile            = cms.FileInPath('FWLJMET/LJMet/data/BEST_mlp.json'),
+        numSubjetsMin      = cms.int32(2),
+        numDaughtersMin    = cms.int32(3),
+        jetSoftDropMassMin = cms.double(10.0),
+        jetPtMin           = cms.double(170.0),
+        radiusSmall        = cms.double(0.4),
+        radiusLarge        = cms.double(0.8),
+        reclusterJetPtMin  = cms.double(20.0),
+        jetChargeKappa     = cms.double(0.6),
+        maxJetSize         = cms.int32(4),
+    )
+
+process.p = cms.Path(process.ljmetBenchmark)